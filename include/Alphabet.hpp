@@ -18,6 +18,8 @@
 #ifndef _ALPHABET_H
 #define _ALPHABET_H
 
+#include "Divisor.hpp"
+
 #include <iostream>
 #include <fstream>
 #include <math.h>
@@ -40,16 +42,23 @@ class Alphabet {
 
   int build_from_text(char const *filename);
   int build(char const *filename);
+  int build_from_characters(std::string const &characters);
 
   value_type get_word_value(std::string const &word) const;
   value_type get_word_value(std::string const &word, size_type const start,
                         size_type const end) const;
+  value_type get_reversed_word_value(std::string const &word, size_type const start,
+                                     size_type const end) const;
   std::string get_word_from_value(size_type const value, size_type const word_size) const;
 
   static Alphabet *load(std::istream &file);
   void save(std::ostream &file) const;
 
   unsigned long long pow_wsize(size_type const power) const;
+  // division by size^power without the division instruction, for scanning loops
+  Divisor const &get_divisor(size_type const power) const {
+      return m_divisors[power];
+  }
   bool validate_word(std::string const &word) const;
 
   size_type size() const {
@@ -66,6 +75,10 @@ class Alphabet {
 
  private:
   void count_ifpower2();
+  void compute_powers();
+
+  // powers 0..63, every word value fitting in 64 bits needs fewer characters
+  static size_type const MAX_POWER = 64;
 
   size_type m_size;
   uint  m_alphabet[ASCII];
@@ -73,11 +86,12 @@ class Alphabet {
 
   bool m_if_power2;
   uint m_power2;
+  value_type m_powers[MAX_POWER];
+  Divisor m_divisors[MAX_POWER];
 };
 
 inline unsigned long long Alphabet::pow_wsize(size_type const power) const {
-    return m_if_power2 ? ((unsigned long long) 1) << (m_power2 * power) :
-           (unsigned long long) pow(m_size, power);
+    return m_powers[power];
 }
 
 }
@@ -0,0 +1,145 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#ifndef _BUCKETDIRECTORY_H
+#define _BUCKETDIRECTORY_H
+
+#include <stdexcept>
+#include <string>
+
+#include <sdsl/bit_vectors.hpp>
+
+namespace cdat {
+
+/*
+ * Bucket bounds of the index: bit vector with one 1 per word value and one 0
+ * per sampled word. The bit vector representation is chosen at build time.
+ */
+class BucketDirectory {
+ public:
+  typedef uint64_t size_type;
+
+  static uint const PLAIN = 0;
+  static uint const SPARSE = 1;
+  static uint const RRR = 2;
+
+  virtual ~BucketDirectory() {};
+
+  virtual size_type select1(size_type const idx) const = 0;
+  // only available when directory was created with select0 support
+  virtual size_type select0(size_type const idx) const = 0;
+  virtual size_type rank1(size_type const idx) const = 0;
+  virtual size_type size() const = 0;
+
+  virtual uint get_type() const = 0;
+  virtual double size_in_mega_bytes() const = 0;
+  virtual void save(std::ostream &out) const = 0;
+
+  static BucketDirectory *create(uint const type, sdsl::bit_vector const &bit_vector,
+                                 bool const select0_support);
+  static BucketDirectory *load(std::istream &in);
+
+  static bool parse_type(std::string const &name, uint *type);
+  static std::string get_type_name(uint const type);
+};
+
+template<class t_bit_vector, uint t_type>
+class SdslBucketDirectory : public BucketDirectory {
+ private:
+  t_bit_vector m_bit_vector;
+  typename t_bit_vector::rank_1_type m_rank1;
+  typename t_bit_vector::select_1_type m_select1;
+  typename t_bit_vector::select_0_type *m_select0;
+
+  SdslBucketDirectory() : m_select0(nullptr) {};
+
+ public:
+  SdslBucketDirectory(sdsl::bit_vector const &bit_vector, bool const select0_support) :
+      m_bit_vector(bit_vector), m_rank1(&m_bit_vector), m_select1(&m_bit_vector),
+      m_select0(nullptr) {
+      if (select0_support)
+          m_select0 = new typename t_bit_vector::select_0_type(&m_bit_vector);
+  }
+
+  ~SdslBucketDirectory() { delete m_select0; }
+
+  size_type select1(size_type const idx) const {
+      return m_select1.select(idx);
+  }
+
+  size_type select0(size_type const idx) const {
+      return m_select0->select(idx);
+  }
+
+  size_type rank1(size_type const idx) const {
+      return m_rank1.rank(idx);
+  }
+
+  size_type size() const {
+      return m_bit_vector.size();
+  }
+
+  uint get_type() const {
+      return t_type;
+  }
+
+  double size_in_mega_bytes() const {
+      double result = sdsl::size_in_mega_bytes(m_bit_vector);
+      result += sdsl::size_in_mega_bytes(m_rank1);
+      result += sdsl::size_in_mega_bytes(m_select1);
+      if (m_select0 != nullptr)
+          result += sdsl::size_in_mega_bytes(*m_select0);
+
+      return result;
+  }
+
+  void save(std::ostream &out) const {
+      uint type = t_type;
+      out.write((char *) &type, sizeof(uint));
+      m_bit_vector.serialize(out);
+      m_rank1.serialize(out);
+      m_select1.serialize(out);
+
+      bool has_select0 = m_select0 != nullptr;
+      out.write((char *) &has_select0, sizeof(bool));
+      if (has_select0)
+          m_select0->serialize(out);
+  }
+
+  static SdslBucketDirectory *load(std::istream &in) {
+      SdslBucketDirectory *directory = new SdslBucketDirectory();
+      directory->m_bit_vector.load(in);
+      directory->m_rank1.load(in, &directory->m_bit_vector);
+      directory->m_select1.load(in, &directory->m_bit_vector);
+
+      bool has_select0;
+      in.read((char *) &has_select0, sizeof(bool));
+      if (has_select0) {
+          directory->m_select0 = new typename t_bit_vector::select_0_type;
+          directory->m_select0->load(in, &directory->m_bit_vector);
+      }
+
+      return directory;
+  }
+};
+
+typedef SdslBucketDirectory<sdsl::bit_vector, BucketDirectory::PLAIN> PlainBucketDirectory;
+typedef SdslBucketDirectory<sdsl::sd_vector<>, BucketDirectory::SPARSE> SparseBucketDirectory;
+typedef SdslBucketDirectory<sdsl::rrr_vector<>, BucketDirectory::RRR> RRRBucketDirectory;
+
+}
+#endif
@@ -0,0 +1,83 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+#ifndef _COLOCATEDDIRECTORY_H
+#define _COLOCATEDDIRECTORY_H
+
+#include "BucketDirectory.hpp"
+#include "PackedArray.hpp"
+#include "Permutation.hpp"
+
+#include <algorithm>
+
+namespace cdat {
+
+/*
+ * Bucket bounds kept next to the first positions of the buckets: a block of
+ * BLOCK_WORDS words holds the permutation start of its first bucket, the end
+ * of every bucket relative to it and the first leading positions of each
+ * bucket, so a lookup of a small bucket reads one block instead of the
+ * select structures and the permutation.
+ */
+class ColocatedDirectory {
+ public:
+  typedef uint64_t size_type;
+  typedef uint64_t value_type;
+
+  static size_type const BLOCK_WORDS = 4;
+
+  ColocatedDirectory() : m_leading(0), m_stride(0) {};
+
+  // -1 when positions in the permutation don't fit 32 bits
+  int build(BucketDirectory const *directory, Permutation const *permutation,
+            size_type const words_number, size_type const leading);
+
+  // [begin, end) of the bucket of word_value in the permutation
+  void get_bucket(value_type const word_value, size_type *begin, size_type *end) const {
+      size_type block = (word_value / BLOCK_WORDS) * m_stride;
+      size_type idx = word_value % BLOCK_WORDS;
+      size_type start = m_blocks.get(block);
+      *begin = start + (idx == 0 ? 0 : m_blocks.get(block + idx));
+      *end = start + m_blocks.get(block + 1 + idx);
+  }
+
+  // first min(leading, size) positions of the bucket of word_value
+  void get_leading(value_type const word_value, size_type const size, value_type *out) const {
+      size_type first = (word_value / BLOCK_WORDS) * m_stride + 1 + BLOCK_WORDS +
+          (word_value % BLOCK_WORDS) * m_leading;
+      m_blocks.decode_range(first, first + std::min(size, m_leading), out);
+  }
+
+  void prefetch(value_type const word_value) const {
+      m_blocks.prefetch((word_value / BLOCK_WORDS) * m_stride);
+  }
+
+  size_type get_leading_number() const {
+      return m_leading;
+  }
+
+  static ColocatedDirectory *load(std::istream &in, uint const version);
+  void save(std::ostream &out) const;
+  double size_in_mega_bytes() const;
+
+ private:
+  size_type m_leading;
+  size_type m_stride;
+  PackedArray m_blocks;
+};
+
+}
+#endif
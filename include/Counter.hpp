@@ -21,6 +21,7 @@
 #include "Alphabet.hpp"
 
 #include <unordered_map>
+#include <vector>
 #include <stdint.h>
 
 #include <libcds/libcdsBasics.h>
@@ -28,97 +29,81 @@
 
 namespace cdat {
 
-template<uint8_t t_width>
-class Counter {
+/*
+ * Counters are a static hierarchy: CounterBase holds the packed storage and
+ * the text scanning kernel, t_counter is the storage policy (Counter,
+ * CounterHashMap, CounterBitVector) whose inc() and get_and_inc() are called
+ * directly, so they are inlined into the scan.
+ */
+template<typename t_counter, uint8_t t_width>
+class CounterBase {
  public:
   static_assert(t_width <= 32 && t_width > 0,
                 "Counter: width must be at most 32 bits and at least 1bits");
   typedef uint64_t size_type;
   typedef uint64_t value_type;
 
-  Counter(size_type const length);
-  virtual ~Counter();
-  virtual value_type get(size_type const idx) const;
-  virtual void set(size_type const idx, value_type const value);
-  virtual void inc(size_type const idx);
+  CounterBase(size_type const length);
+  ~CounterBase();
   size_type size() const;
-  virtual value_type get_and_inc(size_type const idx);
-
-  virtual size_type build_counter(std::ifstream &file, size_type word_size,
-                                  size_type const shift, Alphabet const *alphabet,
-                                  size_type &text_length, size_type &additional_length);
 
-  void prepare_for_permutation();
+  size_type build_counter(std::ifstream &file, size_type word_size,
+                          size_type const shift, Alphabet const *alphabet,
+                          size_type &text_length, size_type &additional_length,
+                          std::vector<size_type> const &cuts);
 
   //make template parameter accessible
   enum { fixed_int_width = t_width };
 
  protected:
+  value_type get_field(size_type const idx) const;
+  void set_field(size_type const idx, value_type const value);
 
   size_type build(std::ifstream &file, size_type const word_size,
                   size_type const shift, Alphabet const *alphabet,
-                  size_type &text_length, size_type &additional_text_length);
+                  size_type &text_length, size_type &additional_text_length,
+                  std::vector<size_type> const &cuts);
+
+  t_counter &derived() {
+      return *static_cast<t_counter *>(this);
+  }
 
  private:
+  CounterBase(CounterBase const &) = delete;
+  CounterBase &operator=(CounterBase const &) = delete;
 
   unsigned int *m_counter;
   size_type m_length;
-
 };
 
-/************** IMPLEMENTATION ******************/
-
-template<uint8_t t_width>
-inline Counter<t_width>::Counter(size_type const length) :
-    m_length(length) {
-    m_counter = new unsigned int[cds_utils::uint_len(t_width, length)];
-}
-
-template<uint8_t t_width>
-inline Counter<t_width>::~Counter() {
-    delete[] m_counter;
-}
-
-template<uint8_t t_width>
-inline typename Counter<t_width>::value_type Counter<t_width>::get(size_type const idx) const {
-    return cds_utils::get_field(m_counter, t_width, idx);
-}
-
-template<uint8_t t_width>
-inline void Counter<t_width>::set(size_type const idx, value_type const value) {
-    cds_utils::set_field(m_counter, t_width, idx, value);
-}
-
-template<uint8_t t_width>
-inline void Counter<t_width>::inc(size_type const idx) {
-    set(idx, get(idx) + 1);
-}
-
-template<uint8_t t_width>
-inline typename Counter<t_width>::size_type Counter<t_width>::size() const {
-    return m_length;
-}
-
-template<uint8_t t_width>
-inline typename Counter<t_width>::value_type Counter<t_width>::get_and_inc(size_type const idx) {
-    unsigned int result = get(idx);
-    set(idx, result + 1);
-
-    return result;
+/*
+ * Calls visit(word_value) for every shift-th word of the text, the last word
+ * is padded with the first character. Words spanning one of the sorted cuts
+ * of the text are skipped. Returns the number of visited words.
+ */
+// true when a cut lies inside (start, end), next_cut moves on over the cuts at or before start,
+// so words are checked in text order
+inline bool spans_cut(std::vector<uint64_t> const &cuts, uint64_t const start, uint64_t const end,
+                      uint64_t *next_cut) {
+    while (*next_cut < cuts.size() && cuts[*next_cut] <= start)
+        ++(*next_cut);
+
+    return *next_cut < cuts.size() && cuts[*next_cut] < end;
 }
 
-template<uint8_t t_width>
-typename Counter<t_width>::value_type Counter<t_width>::build(std::ifstream &file, size_type const word_size,
-                                                              size_type const shift, Alphabet const *alphabet,
-                                                              size_type &text_length, size_type &additional_text_length) {
-    size_type words_number = 0;
-    size_type word_length = 0, word_value = 0;
-    size_type divisor = pow(alphabet->size(), word_size - shift);
+template<typename t_visitor>
+uint64_t scan_words(std::ifstream &file, uint64_t const word_size, uint64_t const shift,
+                    Alphabet const *alphabet, uint64_t &text_length,
+                    uint64_t &additional_text_length, std::vector<uint64_t> const &cuts,
+                    t_visitor &&visit) {
+    uint64_t words_number = 0;
+    uint64_t word_length = 0, word_value = 0;
+    uint64_t word_start = 0, next_cut = 0;
+    Divisor const &divisor = alphabet->get_divisor(word_size - shift);
     additional_text_length = 0;
     text_length = 0;
 
     bool additional_word = false;
-    size_type char_counter = 0;
     const size_t BUFFER_SIZE = 16 * 1024;
     char buffer[BUFFER_SIZE];
     size_t bytes_read;
@@ -134,9 +119,12 @@ typename Counter<t_width>::value_type Counter<t_width>::build(std::ifstream &fil
             if (!additional_word)
                 additional_word = true;
             if (word_length == word_size) {
-                inc(word_value);
-                ++words_number;
-                word_value %= divisor;
+                if (!spans_cut(cuts, word_start, word_start + word_size, &next_cut)) {
+                    visit(word_value);
+                    ++words_number;
+                }
+                word_start += shift;
+                word_value = divisor.modulo(word_value);
                 word_length -= shift;
                 additional_word = false;
             }
@@ -151,63 +139,126 @@ typename Counter<t_width>::value_type Counter<t_width>::build(std::ifstream &fil
             additional_text_length++;
         }
 
-        inc(word_value);
-        ++words_number;
+        if (!spans_cut(cuts, word_start, text_length, &next_cut)) {
+            visit(word_value);
+            ++words_number;
+        }
     }
 
     return words_number;
 }
 
 template<uint8_t t_width>
-typename Counter<t_width>::value_type Counter<t_width>::build_counter(std::ifstream &file, size_type word_size,
-                                                                      size_type const shift, Alphabet const *alphabet,
-                                                                      size_type &text_length, size_type &additional_length) {
-    for (size_type i = 0; i < m_length; ++i)
-        set(i, 0);
+class Counter : public CounterBase<Counter<t_width>, t_width> {
+ public:
+  typedef CounterBase<Counter<t_width>, t_width> base_type;
+  typedef typename base_type::size_type size_type;
+  typedef typename base_type::value_type value_type;
 
-    return Counter<t_width>::build(file, word_size, shift, alphabet,
-                                   text_length, additional_length);
+  Counter(size_type const length) : base_type(length) {};
+  value_type get(size_type const idx) const;
+  void set(size_type const idx, value_type const value);
+  void inc(size_type const idx);
+  value_type get_and_inc(size_type const idx);
+
+  void prepare_for_permutation();
+};
+
+/************** IMPLEMENTATION ******************/
+
+template<typename t_counter, uint8_t t_width>
+inline CounterBase<t_counter, t_width>::CounterBase(size_type const length) :
+    m_length(length) {
+    m_counter = new unsigned int[cds_utils::uint_len(t_width, length)];
 }
 
-template<uint8_t t_width>
-inline void Counter<t_width>::prepare_for_permutation() {
-    for (uint i = 0; i < m_length; ++i)
-        set(i, 0);
+template<typename t_counter, uint8_t t_width>
+inline CounterBase<t_counter, t_width>::~CounterBase() {
+    delete[] m_counter;
 }
 
-/************** TEMPLATE SPECIALIZATION ************/
+template<typename t_counter, uint8_t t_width>
+inline typename CounterBase<t_counter, t_width>::size_type CounterBase<t_counter, t_width>::size() const {
+    return m_length;
+}
 
-template<>
-inline Counter<32>::Counter(size_type const length) : m_length(length) {
-    m_counter = new unsigned int[length];
+template<typename t_counter, uint8_t t_width>
+inline typename CounterBase<t_counter, t_width>::value_type
+CounterBase<t_counter, t_width>::get_field(size_type const idx) const {
+    if (t_width == 32)
+        return m_counter[idx];
+    return cds_utils::get_field(m_counter, t_width, idx);
 }
 
-template<>
-inline void Counter<32>::set(size_type const idx, value_type const value) {
-    m_counter[idx] = value;
+template<typename t_counter, uint8_t t_width>
+inline void CounterBase<t_counter, t_width>::set_field(size_type const idx, value_type const value) {
+    if (t_width == 32)
+        m_counter[idx] = value;
+    else
+        cds_utils::set_field(m_counter, t_width, idx, value);
 }
 
-template<>
-inline void Counter<32>::inc(size_type const idx) {
-    ++m_counter[idx];
+template<typename t_counter, uint8_t t_width>
+typename CounterBase<t_counter, t_width>::size_type
+CounterBase<t_counter, t_width>::build(std::ifstream &file, size_type const word_size,
+                                       size_type const shift, Alphabet const *alphabet,
+                                       size_type &text_length, size_type &additional_text_length,
+                                       std::vector<size_type> const &cuts) {
+    t_counter &counter = derived();
+    return scan_words(file, word_size, shift, alphabet, text_length, additional_text_length, cuts,
+                      [&counter](value_type const word_value) { counter.inc(word_value); });
 }
 
-template<>
-inline typename Counter<32>::size_type Counter<32>::size() const {
-    return m_length;
+template<typename t_counter, uint8_t t_width>
+typename CounterBase<t_counter, t_width>::size_type
+CounterBase<t_counter, t_width>::build_counter(std::ifstream &file, size_type word_size,
+                                               size_type const shift, Alphabet const *alphabet,
+                                               size_type &text_length, size_type &additional_length,
+                                               std::vector<size_type> const &cuts) {
+    for (size_type i = 0; i < m_length; ++i)
+        derived().set(i, 0);
+
+    return build(file, word_size, shift, alphabet, text_length, additional_length, cuts);
 }
 
-template<>
-inline typename Counter<32>::value_type Counter<32>::get_and_inc(size_type const idx) {
-    return m_counter[idx]++;
+template<uint8_t t_width>
+inline typename Counter<t_width>::value_type Counter<t_width>::get(size_type const idx) const {
+    return this->get_field(idx);
+}
+
+template<uint8_t t_width>
+inline void Counter<t_width>::set(size_type const idx, value_type const value) {
+    this->set_field(idx, value);
+}
+
+template<uint8_t t_width>
+inline void Counter<t_width>::inc(size_type const idx) {
+    this->set_field(idx, this->get_field(idx) + 1);
+}
+
+template<uint8_t t_width>
+inline typename Counter<t_width>::value_type Counter<t_width>::get_and_inc(size_type const idx) {
+    value_type result = this->get_field(idx);
+    this->set_field(idx, result + 1);
+
+    return result;
+}
+
+template<uint8_t t_width>
+inline void Counter<t_width>::prepare_for_permutation() {
+    for (size_type i = 0; i < this->size(); ++i)
+        set(i, 0);
 }
 
+/************** TEMPLATE SPECIALIZATION ************/
+
+// full width counters keep bucket starts, so get_and_inc gives the permutation cell
 template<>
 inline void Counter<32>::prepare_for_permutation() {
     value_type sum = 0;
     for (size_type i = 0; i < size(); ++i) {
-        value_type temp = m_counter[i];
-        m_counter[i] = sum;
+        value_type temp = get_field(i);
+        set_field(i, sum);
         sum += temp;
     }
 }
@@ -215,22 +266,21 @@ inline void Counter<32>::prepare_for_permutation() {
 /*********** EXTENDED COUNTERS **************/
 
 template<uint8_t t_width>
-class CounterHashMap : public Counter<t_width> {
+class CounterHashMap : public CounterBase<CounterHashMap<t_width>, t_width> {
  public:
   static_assert(t_width <= 31 && t_width > 0,
                 "Counter: width must be at most 31 bits and at least 1 bits");
-  typedef typename Counter<t_width>::size_type size_type;
-  typedef typename Counter<t_width>::value_type value_type;
+  typedef CounterBase<CounterHashMap<t_width>, t_width> base_type;
+  typedef typename base_type::size_type size_type;
+  typedef typename base_type::value_type value_type;
 
   CounterHashMap(size_type const length);
-  ~CounterHashMap();
   value_type get(size_type const idx) const;
   void set(size_type const idx, value_type const value);
   void inc(size_type const idx);
   value_type get_and_inc(size_type const idx);
 
-  //make template parameter accessible
-  enum { fixed_int_width = t_width };
+  void prepare_for_permutation();
 
  private:
   const uint MAX_VALUE;
@@ -240,18 +290,13 @@ class CounterHashMap : public Counter<t_width> {
 
 template<uint8_t t_width>
 CounterHashMap<t_width>::CounterHashMap(size_type const length) :
-    Counter<t_width>(length), MAX_VALUE((1 << t_width) - 1) {
+    base_type(length), MAX_VALUE((1 << t_width) - 1) {
     hash_map.reserve(1 << 14);
 }
 
-template<uint8_t t_width>
-CounterHashMap<t_width>::~CounterHashMap() {
-
-}
-
 template<uint8_t t_width>
 inline typename CounterHashMap<t_width>::value_type CounterHashMap<t_width>::get(size_type const idx) const {
-    value_type result = Counter<t_width>::get(idx);
+    value_type result = this->get_field(idx);
     if (result < MAX_VALUE)
         return result;
     else {
@@ -262,18 +307,18 @@ inline typename CounterHashMap<t_width>::value_type CounterHashMap<t_width>::get
 template<uint8_t t_width>
 inline void CounterHashMap<t_width>::set(size_type const idx, value_type const value) {
     if (value >= MAX_VALUE) {
-        Counter<t_width>::set(idx, MAX_VALUE);
+        this->set_field(idx, MAX_VALUE);
         hash_map[idx] = value;
     }
     else
-        Counter<t_width>::set(idx, value);
+        this->set_field(idx, value);
 }
 
 template<uint8_t t_width>
 inline void CounterHashMap<t_width>::inc(size_type const idx) {
-    value_type value = Counter<t_width>::get(idx);
+    value_type value = this->get_field(idx);
     if (value < MAX_VALUE) {
-        Counter<t_width>::set(idx, value + 1);
+        this->set_field(idx, value + 1);
 
         if (value + 1 == MAX_VALUE)
             hash_map[idx] = MAX_VALUE;
@@ -285,10 +330,10 @@ inline void CounterHashMap<t_width>::inc(size_type const idx) {
 
 template<uint8_t t_width>
 inline typename CounterHashMap<t_width>::value_type CounterHashMap<t_width>::get_and_inc(size_type const idx) {
-    value_type result = Counter<t_width>::get(idx);
+    value_type result = this->get_field(idx);
 
     if (result < MAX_VALUE) {
-        Counter<t_width>::set(idx, result + 1);
+        this->set_field(idx, result + 1);
         if (result + 1 == MAX_VALUE)
             hash_map[idx] = MAX_VALUE;
     }
@@ -299,12 +344,23 @@ inline typename CounterHashMap<t_width>::value_type CounterHashMap<t_width>::get
 }
 
 template<uint8_t t_width>
-class CounterBitVector : public Counter<t_width> {
+inline void CounterHashMap<t_width>::prepare_for_permutation() {
+    for (size_type i = 0; i < this->size(); ++i)
+        this->set_field(i, 0);
+}
+
+/*
+ * Counts saturated words in a second pass over the text: the first pass
+ * counts up to MAX_VALUE, words that reached it get a full width cell.
+ */
+template<uint8_t t_width>
+class CounterBitVector : public CounterBase<CounterBitVector<t_width>, t_width> {
  public:
   static_assert(t_width <= 31 && t_width > 0,
                 "Counter: width must be at most 31 bits and at least 1 bits");
-  typedef typename Counter<t_width>::size_type size_type;
-  typedef typename Counter<t_width>::value_type value_type;
+  typedef CounterBase<CounterBitVector<t_width>, t_width> base_type;
+  typedef typename base_type::size_type size_type;
+  typedef typename base_type::value_type value_type;
 
   CounterBitVector(size_type const length);
   ~CounterBitVector();
@@ -315,12 +371,14 @@ class CounterBitVector : public Counter<t_width> {
 
   size_type build_counter(std::ifstream &file, size_type word_size,
                           size_type const shift, Alphabet const *alphabet,
-                          size_type &text_length, size_type &additional_length);
+                          size_type &text_length, size_type &additional_length,
+                          std::vector<size_type> const &cuts);
 
-  //make template parameter accessible
-  enum { fixed_int_width = t_width };
+  void prepare_for_permutation();
 
  private:
+  void clear_extended();
+
   const value_type MAX_VALUE;
   bool m_extended;
   uint *m_extended_counter;
@@ -330,22 +388,28 @@ class CounterBitVector : public Counter<t_width> {
 
 template<uint8_t t_width>
 inline CounterBitVector<t_width>::CounterBitVector(size_type const length) :
-    Counter<t_width>(length), MAX_VALUE((1 << t_width) - 1), m_extended(false) {
+    base_type(length), MAX_VALUE((1 << t_width) - 1), m_extended(false) {
     m_extended_counter = NULL;
 }
 
 template<uint8_t t_width>
 CounterBitVector<t_width>::~CounterBitVector() {
+    clear_extended();
+}
+
+template<uint8_t t_width>
+void CounterBitVector<t_width>::clear_extended() {
     if (m_extended) {
         delete[] m_extended_counter;
         delete m_rank1;
         delete m_bitvector;
+        m_extended = false;
     }
 }
 
 template<uint8_t t_width>
 inline typename CounterBitVector<t_width>::value_type CounterBitVector<t_width>::get(size_type const idx) const {
-    size_type result = Counter<t_width>::get(idx);
+    size_type result = this->get_field(idx);
     if (m_extended && result == MAX_VALUE)
         return m_extended_counter[m_rank1->rank(idx)];
 
@@ -355,9 +419,9 @@ inline typename CounterBitVector<t_width>::value_type CounterBitVector<t_width>:
 template<uint8_t t_width>
 inline void CounterBitVector<t_width>::set(size_type const idx, value_type const value) {
     if (value < MAX_VALUE)
-        Counter<t_width>::set(idx, value);
+        this->set_field(idx, value);
     else {
-        Counter<t_width>::set(idx, MAX_VALUE);
+        this->set_field(idx, MAX_VALUE);
 
         if (m_extended)
             m_extended_counter[m_rank1->rank(idx)] = value;
@@ -366,9 +430,9 @@ inline void CounterBitVector<t_width>::set(size_type const idx, value_type const
 
 template<uint8_t t_width>
 inline void CounterBitVector<t_width>::inc(size_type const idx) {
-    value_type value = Counter<t_width>::get(idx);
+    value_type value = this->get_field(idx);
     if (!m_extended && value < MAX_VALUE) {
-        Counter<t_width>::set(idx, value + 1);
+        this->set_field(idx, value + 1);
     }
     else if (m_extended && value == MAX_VALUE) {
         ++m_extended_counter[m_rank1->rank(idx)];
@@ -378,9 +442,9 @@ inline void CounterBitVector<t_width>::inc(size_type const idx) {
 
 template<uint8_t t_width>
 inline typename CounterBitVector<t_width>::value_type CounterBitVector<t_width>::get_and_inc(size_type const idx) {
-    value_type result = Counter<t_width>::get(idx);
+    value_type result = this->get_field(idx);
     if (result < MAX_VALUE) {
-        Counter<t_width>::set(idx, result + 1);
+        this->set_field(idx, result + 1);
         if (result + 1 == MAX_VALUE)
             m_extended_counter[m_rank1->rank(idx)] = MAX_VALUE;
     }
@@ -391,5 +455,40 @@ inline typename CounterBitVector<t_width>::value_type CounterBitVector<t_width>:
 
 }
 
+template<uint8_t t_width>
+typename CounterBitVector<t_width>::size_type
+CounterBitVector<t_width>::build_counter(std::ifstream &file, size_type word_size,
+                                         size_type const shift, Alphabet const *alphabet,
+                                         size_type &text_length, size_type &additional_length,
+                                         std::vector<size_type> const &cuts) {
+    clear_extended();
+    size_type words_number = base_type::build_counter(file, word_size, shift, alphabet,
+                                                      text_length, additional_length, cuts);
+
+    m_bitvector = new sdsl::bit_vector(this->size(), 0);
+    size_type saturated = 0;
+    for (size_type i = 0; i < this->size(); ++i) {
+        if (this->get_field(i) == MAX_VALUE) {
+            (*m_bitvector)[i] = 1;
+            ++saturated;
+        }
+    }
+    m_rank1 = new sdsl::bit_vector::rank_1_type(m_bitvector);
+    m_extended_counter = new uint[saturated]();
+    m_extended = true;
+
+    file.clear();
+    file.seekg(0, std::ios::beg);
+    this->build(file, word_size, shift, alphabet, text_length, additional_length, cuts);
+
+    return words_number;
+}
+
+template<uint8_t t_width>
+inline void CounterBitVector<t_width>::prepare_for_permutation() {
+    for (size_type i = 0; i < this->size(); ++i)
+        this->set_field(i, 0);
+}
+
 }
 #endif
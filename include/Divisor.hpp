@@ -0,0 +1,95 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#ifndef _DIVISOR_H
+#define _DIVISOR_H
+
+#include <stdint.h>
+
+namespace cdat {
+
+/*
+ * Division of 64-bit values by a constant without the division instruction:
+ * multiplication by a precomputed inverse followed by a shift (round-up method,
+ * as in libdivide). Results are exact for every numerator, powers of two use
+ * a plain shift.
+ */
+class Divisor {
+ public:
+  typedef uint64_t value_type;
+
+  Divisor() : m_divisor(1), m_magic(0), m_shift(0), m_add(false) {};
+  explicit Divisor(value_type const divisor);
+
+  value_type divide(value_type const value) const {
+      if (m_magic == 0)
+          return value >> m_shift;
+
+      value_type quotient = (value_type) (((unsigned __int128) m_magic * value) >> 64);
+      if (m_add)
+          return (((value - quotient) >> 1) + quotient) >> m_shift;
+
+      return quotient >> m_shift;
+  }
+
+  value_type modulo(value_type const value) const {
+      return value - divide(value) * m_divisor;
+  }
+
+  value_type get() const {
+      return m_divisor;
+  }
+
+ private:
+  value_type m_divisor;
+  value_type m_magic;
+  uint32_t m_shift;
+  bool m_add;
+};
+
+inline Divisor::Divisor(value_type const divisor) : m_divisor(divisor), m_magic(0), m_shift(0), m_add(false) {
+    if (divisor == 0)
+        return;
+
+    uint32_t floor_log = 63 - __builtin_clzll(divisor);
+    if ((divisor & (divisor - 1)) == 0) {
+        m_shift = floor_log;
+        return;
+    }
+
+    // 2^(64 + floor_log) / divisor does not fit in 64 bits when the quotient
+    // error is too large, then one more bit is kept by the add step of divide
+    unsigned __int128 numerator = (unsigned __int128) 1 << (64 + floor_log);
+    value_type proposed = (value_type) (numerator / divisor);
+    value_type remainder = (value_type) (numerator % divisor);
+
+    if (divisor - remainder < ((value_type) 1 << floor_log)) {
+        m_shift = floor_log;
+    }
+    else {
+        proposed += proposed;
+        value_type twice_remainder = remainder + remainder;
+        if (twice_remainder >= divisor || twice_remainder < remainder)
+            proposed += 1;
+        m_shift = floor_log;
+        m_add = true;
+    }
+    m_magic = proposed + 1;
+}
+
+}
+#endif
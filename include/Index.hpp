@@ -19,12 +19,23 @@
 #define _INDEX_H
 
 #include "Alphabet.hpp"
+#include "BucketDirectory.hpp"
+#include "ColocatedDirectory.hpp"
 #include "config/Config.h"
 #include "Counter.hpp"
+#include "MappedFile.hpp"
+#include "MaskedRuns.hpp"
+#include "PairFilter.hpp"
 #include "Permutation.hpp"
+#include "QGramTable.hpp"
+#include "Records.hpp"
+#include "RepeatBuckets.hpp"
+#include "SuffixDirectory.hpp"
+#include "TaskScheduler.hpp"
 
 #include <string.h>
 #include <fstream>
+#include <mutex>
 
 #include <sdsl/bit_vectors.hpp>
 
@@ -35,13 +46,28 @@ class Index {
   typedef uint64_t size_type;
   typedef uint64_t value_type;
 
-  Index() : m_word_size(0), m_shift(0), m_text_length(0), m_additional_text_length(0) {};
+  Index() : m_word_size(0), m_shift(0), m_text_length(0), m_additional_text_length(0),
+            m_directory(nullptr), m_permutation(nullptr), m_alphabet(nullptr), m_qgram_table(nullptr), m_build_qgram_table(false),
+            m_suffix_directory(nullptr), m_build_suffix_directory(false),
+            m_directory_type(BucketDirectory::PLAIN),
+            m_repeat_buckets(nullptr), m_repeat_threshold(0), m_masked_runs(nullptr),
+            m_records(nullptr), m_shared_boundaries(false), m_colocated_directory(nullptr), m_colocated_leading(0),
+            m_pair_filter(nullptr), m_pair_filter_bits(0), m_mapped_file(nullptr), m_deferred_sections(false), m_file_version(FILE_VERSION) {};
   Index(size_type word_size, size_type transition) : m_word_size(word_size),
-                                                     m_shift(transition), m_additional_text_length(0) {}
+                                                     m_shift(transition), m_additional_text_length(0),
+                                                     m_directory(nullptr), m_permutation(nullptr),
+                                                     m_alphabet(nullptr), m_qgram_table(nullptr), m_build_qgram_table(false),
+                                                     m_suffix_directory(nullptr), m_build_suffix_directory(false),
+                                                     m_directory_type(BucketDirectory::PLAIN),
+                                                     m_repeat_buckets(nullptr), m_repeat_threshold(0),
+                                                     m_masked_runs(nullptr), m_records(nullptr),
+                                                     m_shared_boundaries(false),
+                                                     m_colocated_directory(nullptr), m_colocated_leading(0),
+                                                     m_pair_filter(nullptr), m_pair_filter_bits(0),
+                                                     m_mapped_file(nullptr), m_deferred_sections(false),
+                                                     m_file_version(FILE_VERSION) {}
   Index(size_type word_size, size_type transition, size_type text_length,
-        size_type additional_text_length, sdsl::bit_vector *bit_vector,
-        sdsl::bit_vector::rank_1_type *m_rank1,
-        sdsl::bit_vector::select_1_type *m_select1,
+        size_type additional_text_length, BucketDirectory *directory,
         Permutation *permutation, Alphabet *alphabet);
 
   virtual ~Index();
@@ -52,60 +78,292 @@ class Index {
   int count(std::string const  &pattern, ulong const length, ulong *numocc) const;
   int locate_index(std::string const &pattern, ulong const from, std::vector<ulong> *occ, ulong *numocc) const;
   int locate(std::string const &pattern, ulong const length, std::vector<ulong> *occ, ulong *numocc) const;
-  virtual int extract(ulong const from, ulong const to, std::string *text, ulong *length) const = 0;
-
+  // same results as count and locate on every pattern, patterns are run in groups of
+  // QUERY_GROUP and each lookup step is prefetched for the whole group before it is read
+  void count_batch(std::vector<std::string> const &patterns, std::vector<ulong> *numocc) const;
+  void locate_batch(std::vector<std::string> const &patterns, std::vector<std::vector<ulong> > *occ,
+                    std::vector<ulong> *numocc) const;
+  // same results as count and locate on every pattern, patterns are tasks of scheduler and
+  // full word scans longer than SLICE_CELLS cells are split into slices run as tasks of their own
+  void count_parallel(std::vector<std::string> const &patterns, TaskScheduler *scheduler,
+                      std::vector<ulong> *numocc) const;
+  void locate_parallel(std::vector<std::string> const &patterns, TaskScheduler *scheduler,
+                       std::vector<std::vector<ulong> > *occ, std::vector<ulong> *numocc) const;
+  int extract(ulong const from, ulong const to, std::string *text, ulong *length) const;
+
+  // part of the full word scan of a pattern, cells [begin, end) of the bucket of the word
+  // starting at offset start of the pattern
+  struct Slice {
+    size_type start;
+    size_type begin;
+    size_type end;
+  };
+
+  // splits the full word scan of pattern into slices of at most max_cells cells in scan order,
+  // false when the pattern is not answered by the full word scan alone
+  virtual bool split_query(std::string const &pattern, size_type const max_cells,
+                           std::vector<Slice> *slices) const;
+  // occurrences found by the slices of split_query add up to those of count and locate
+  int count_slice(std::string const &pattern, Slice const &slice, ulong *numocc) const;
+  int locate_slice(std::string const &pattern, Slice const &slice, std::vector<ulong> *occ,
+                   ulong *numocc) const;
+
+  // index file starts with a header and a table of sections (core, permutation, text),
+  // see save_index
   static Index* load_index(std::istream& in);
-  virtual void load(std::istream& in);
-  virtual int save_index(std::ostream &out) const;
+  // loads index from a mapping of the file, permutations are used in place, permutation
+  // and text sections are read by the first query that needs them
+  static Index* map_index(char const *filename);
+  void load(std::istream& in);
+  int save_index(std::ostream &out) const;
+  // reads sections deferred by map_index, no-op for an index loaded in full
+  void load_sections() const;
+  // size of the loaded sections
   virtual double get_size_in_mega_bytes() const;
 
+  static uint const FILE_MAGIC;
+  static uint const FILE_VERSION;
+  static const uint CORE_SECTION = 0;
+  static const uint PERMUTATION_SECTION = 1;
+  static const uint TEXT_SECTION = 2;
+  static const uint SECTIONS_NUMBER = 3;
+  static const uint QUERY_GROUP = 16;
+  static const uint SLICE_CELLS = 1 << 14;
+  static const uint PAIR_GROUP = 8;
+  static const uint FILTER_CELLS = 16;
+
+  // build counts of all words shorter than word size, used by count on short patterns
+  void set_qgram_table(bool const enabled) {
+      m_build_qgram_table = enabled;
+  }
+
+  // build second directory ordered by word suffixes, used by count_short_left
+  void set_suffix_directory(bool const enabled) {
+      m_build_suffix_directory = enabled;
+  }
+
+  // bit vector representation of the bucket directory, see BucketDirectory
+  void set_directory_type(uint const type) {
+      m_directory_type = type;
+  }
+
+  // keep buckets larger than threshold ordered by the following word, 0 disables
+  void set_repeat_threshold(size_type const threshold) {
+      m_repeat_threshold = threshold;
+  }
+
+  // runs cut out of the indexed text, positions are reported in the original text,
+  // occurrences spanning a cut are dropped, index takes ownership
+  void set_masked_runs(MaskedRuns *masked_runs) {
+      m_masked_runs = masked_runs;
+  }
+
+  // record boundaries of a multi-sequence text, occurrences spanning a boundary
+  // are dropped, index takes ownership
+  void set_records(Records *records) {
+      m_records = records;
+  }
+
+  // keep bucket bounds of every ColocatedDirectory::BLOCK_WORDS words together with
+  // the first leading positions of their buckets, 0 disables
+  void set_colocated_directory(size_type const leading) {
+      m_colocated_leading = leading;
+  }
+
+  // keep a filter of pairs of consecutive indexed words with bits_per_pair bits per pair,
+  // patterns holding an absent pair are answered without the full word scan, 0 disables
+  void set_pair_filter(size_type const bits_per_pair) {
+      m_pair_filter_bits = bits_per_pair;
+  }
+
+  // records and masked runs of owner, which keeps them, for a level built over the same text,
+  // occurrences stay in indexed positions for owner to map
+  void share_boundaries(Index const *owner) {
+      m_records = owner->m_records;
+      m_masked_runs = owner->m_masked_runs;
+      m_shared_boundaries = true;
+  }
+
+  Records const *get_records() const {
+      return m_records;
+  }
+
+  MaskedRuns const *get_masked_runs() const {
+      return m_masked_runs;
+  }
+
+  BucketDirectory const *get_directory() const {
+      return m_directory;
+  }
+
+  size_type get_word_size() const {
+      return m_word_size;
+  }
+
+  size_type get_shift() const {
+      return m_shift;
+  }
+
+  size_type get_text_length() const {
+      return m_text_length;
+  }
+
  protected:
 
   /*********   FUNCTIONS  ********/
 
   size_type rank_0(size_type const idx) const;
+  virtual uint get_index_type() const = 0;
+  virtual int extract_text(ulong const from, ulong const to, std::string *text, ulong *length) const = 0;
   virtual value_type extract_value(size_type const from, size_type const length) const = 0;
 
-  int count_short(std::string const &pattern, ulong length,
-                  bool const locate, ulong *numocc, std::vector<ulong> *occ) const;
-  int count_short_right(std::string const &pattern, bool const locate, ulong *numocc,
-                        std::vector<ulong> *occ) const;
-  int count_short_left(std::string const &pattern, bool const locate, ulong *numocc,
-                       std::vector<ulong> *occ) const;
-
+  // every index type instantiates the short pattern kernels below with its own
+  // extractor, so text access inside the candidate loops is not a virtual call
+  virtual int count_short(std::string const &pattern, ulong length,
+                          bool const locate, ulong *numocc, std::vector<ulong> *occ) const = 0;
+  void plan_short(std::string const &pattern, std::vector<bool> *right_side) const;
+
+  template<typename Extractor>
+  int count_short_kernel(std::string const &pattern, ulong length, Extractor const &extract_value,
+                         bool const locate, ulong *numocc, std::vector<ulong> *occ) const;
+  template<typename Extractor>
+  int count_short_right(std::string const &pattern, std::vector<bool> const &right_side,
+                        Extractor const &extract_value, bool const locate,
+                        ulong *numocc, std::vector<ulong> *occ) const;
+  template<typename Extractor>
+  int count_short_left(std::string const &pattern, std::vector<bool> const &right_side,
+                       Extractor const &extract_value, bool const locate,
+                       ulong *numocc, std::vector<ulong> *occ) const;
+  template<typename Extractor>
+  int count_short_left_suffix(std::string const &pattern, std::vector<bool> const &right_side,
+                              Extractor const &extract_value, bool const locate,
+                              ulong *numocc, std::vector<ulong> *occ) const;
+  // occurrences near cuts whose word chosen by right_side was skipped, scans about
+  // m_word_size + m_shift positions around every cut
+  template<typename Extractor>
+  void add_cut_occ(std::string const &pattern, std::vector<bool> const &right_side,
+                   Extractor const &extract_value, bool const locate,
+                   ulong *numocc, std::vector<ulong> *occ) const;
+
+  // scans only the cells of slice when it is given
   virtual int count_full_words(std::string const &pattern, ulong length,
                                bool const locate, ulong *numocc,
-                               std::vector<ulong> *occ) const = 0;
+                               std::vector<ulong> *occ, Slice const *slice) const = 0;
 
   int count_exact_size_word(std::string const &pattern, size_type length,
-                            ulong *numocc, bool const locate, std::vector<ulong> *occ) const;
+                            ulong *numocc, bool const locate, std::vector<ulong> *occ,
+                            Slice const *slice) const;
 
+  // drops positions of cells [start, end) whose occurrence ends past segment_end, pushes
+  // the others to occ unless it is NULL
   void verify_occurrences(size_type const start, size_type const end, size_type const length,
                           size_type const offset, ulong *numocc, std::vector<ulong> *occ) const;
 
+  // end of the record holding position of the indexed text or the next cut after it, text
+  // length when the index has neither; kernels reject candidates ending past it
+  size_type segment_end(size_type const position) const {
+      if (m_records == nullptr && m_masked_runs == nullptr)
+          return m_text_length;
+
+      return boundary_end(position);
+  }
+  size_type boundary_end(size_type const position) const;
+  // false when occurrence [position, position + length) runs into the next record, over a cut
+  // or into the padding of the last word
+  bool in_segment(size_type const position, size_type const length) const {
+      return position + length <= segment_end(position);
+  }
+  // index types whose text is read from the permutation keep words spanning cuts
+  virtual bool skips_cut_words() const {
+      return true;
+  }
+  // true when the word starting at position spans a cut and was left out of the permutation
+  bool skipped_word(size_type const position) const;
+  // words lying inside a bucket may still hold occurrences spanning records or kept words
+  // spanning cuts, so count checks the positions of bucket cells as locate does
+  bool verifies_buckets() const {
+      return m_records != nullptr || (m_masked_runs != nullptr && !skips_cut_words());
+  }
+  // starts of records and cuts in the indexed text, tables holding only counts skip words spanning them
+  void get_boundaries(std::vector<size_type> *boundaries) const;
+  // cuts the words of the permutation must not span, empty when none are skipped
+  void get_cuts(std::vector<size_type> *cuts) const;
+  // shift-th words of the text, those skipped at cuts included, the cells hold indexes below it
+  size_type grid_words_number() const {
+      return (m_text_length + m_additional_text_length - m_word_size) / m_shift + 1;
+  }
+
   size_type get_position_in_permutation(value_type const word_value) const;
+  // [begin, end) of the bucket of word_value in the permutation
+  void get_bucket(value_type const word_value, size_type *begin, size_type *end) const;
+  // text position of the word stored in the permutation as idx
+  virtual size_type sampled_position(value_type const idx) const;
+  // asks for the text around position ahead of a later read, no-op when text has no plain layout
+  virtual void prefetch_text(size_type const) const {};
+  template<typename t_run>
+  void run_interleaved(std::vector<std::string> const &patterns, size_type const from, size_type const to,
+                       t_run run) const;
+  // positions of the bucket [begin, end) of word_value, leading ones from the colocated directory
+  void decode_positions(value_type const word_value, size_type const begin, size_type const end,
+                        std::vector<value_type> *positions) const;
+  void decode_bucket(size_type const begin, size_type const end, value_type const word_value,
+                     std::string const &pattern, size_type const next_start,
+                     std::vector<value_type> *positions) const;
+  // false when every alignment of sampled words in pattern has a pair missing from the pair filter
+  bool may_occur(std::string const &pattern) const;
+  // number of cells scanned by slices
+  static size_type get_cells(std::vector<Slice> const &slices) {
+      size_type result = 0;
+      for (size_type i = 0; i < slices.size(); ++i)
+          result += slices[i].end - slices[i].begin;
+
+      return result;
+  }
+  // positions read by the full word scan for the word at offset start of pattern,
+  // only those of slice when it is given
+  void decode_scan(value_type const word_value, std::string const &pattern, size_type const start,
+                   Slice const *slice, std::vector<value_type> *positions) const;
+
+  // maps occurrences from first on to the original text
+  void to_original(size_type const first, std::vector<ulong> *occ) const;
 
   void add_last_occ(std::string const &pattern, bool const locate,
                     ulong *numocc, std::vector<ulong> *occ) const;
-  void check_occ_end(std::string const &pattern, ulong *numocc) const;
+  void check_occ_end(std::string const &pattern, std::vector<bool> const &right_side,
+                     ulong *numocc) const;
 
   template<typename Counter>
   void create_bit_vector(Counter const &counter,
                          size_type const words_number,
                          size_type const genome_words_number);
-  virtual void create_bit_vector_support();
+  virtual void create_bit_vector_support(sdsl::bit_vector const &bit_vector);
 
   template<typename Counter>
-  void create_permutation(std::ifstream &file, Counter &counter);
+  void create_permutation(std::ifstream &file, Counter &counter, std::vector<size_type> const &cuts);
   void create_permutation(std::ifstream &file, size_type const genome_words_number);
-  virtual Permutation *create_permutation(size_type const size) const;
+  // size cells holding indexes of words below sampled_words
+  virtual Permutation *create_permutation(size_type const size, size_type const sampled_words) const;
+  virtual Permutation *load_permutation(std::istream &in) const;
   value_type perm_binary_search(size_type const word_value, size_type const genome_words_number) const;
 
-  template<uint8_t t_width>
-  value_type inc_counter(Counter<t_width> &counter, value_type const word_value);
+  template<typename t_counter>
+  value_type inc_counter(t_counter &counter, value_type const word_value);
 
+  virtual int create_alphabet(char const *filename);
   virtual void create_text(char const *const filename) {};
   virtual void fill_text(size_type const idx, value_type const value) {};
+  virtual void complete_permutation() {};
+
+  // core section holds everything but the permutation and the text, index types
+  // with own fields write them before calling the base version
+  virtual void save_core(std::ostream &out) const;
+  virtual void load_core(std::istream &in);
+  virtual void save_text(std::ostream &out) const {};
+  virtual void load_text(std::istream &in) {};
+  void read_sections();
+
+  static uint read_header(std::istream &in, size_type *sections, uint *version);
+  static Index *create_index(uint const index_type);
 
 #ifdef DEBUG
   void print_time(timeval &start, char const *const msg);
@@ -117,11 +375,29 @@ class Index {
   size_type m_text_length;
   size_type m_additional_text_length;
 
-  sdsl::bit_vector * m_bit_vector;
-  sdsl::bit_vector::rank_1_type *m_rank1;
-  sdsl::bit_vector::select_1_type *m_select1;
+  BucketDirectory *m_directory;
   Permutation *m_permutation;
   Alphabet *m_alphabet;
+  QGramTable *m_qgram_table;
+  bool m_build_qgram_table;
+  SuffixDirectory *m_suffix_directory;
+  bool m_build_suffix_directory;
+  uint m_directory_type;
+  RepeatBuckets *m_repeat_buckets;
+  size_type m_repeat_threshold;
+  MaskedRuns *m_masked_runs;
+  Records *m_records;
+  bool m_shared_boundaries;
+  ColocatedDirectory *m_colocated_directory;
+  size_type m_colocated_leading;
+  PairFilter *m_pair_filter;
+  size_type m_pair_filter_bits;
+  MappedFile *m_mapped_file;
+  bool m_deferred_sections;
+  // version of the file the index was read from, permutation cells depend on it
+  uint m_file_version;
+  size_type m_sections[2 * SECTIONS_NUMBER];
+  mutable std::once_flag m_sections_loaded;
 
 };
 
@@ -133,16 +409,16 @@ void Index::create_bit_vector(Counter const &counter, size_type const words_numb
     gettimeofday(&start_now, NULL);
 #endif
 
-    m_bit_vector = new sdsl::bit_vector(genome_words_number + words_number + 1, 0);
+    sdsl::bit_vector bit_vector(genome_words_number + words_number + 1, 0);
     size_type position = 0;
-    (*m_bit_vector)[0] = 1;
+    bit_vector[0] = 1;
 
     for (size_type i = 0; i < words_number - 1; ++i) {
         position += counter.get(i) + 1;
-        (*m_bit_vector)[position] = 1;
+        bit_vector[position] = 1;
     }
-    (*m_bit_vector)[genome_words_number + words_number] = 1;
-    create_bit_vector_support();
+    bit_vector[genome_words_number + words_number] = 1;
+    create_bit_vector_support(bit_vector);
 
 #ifdef DEBUG
     print_time(start_now, "bit vector time: ");
@@ -157,8 +433,7 @@ int Index::build(char const *filename) {
     gettimeofday(&start_now, NULL);
 #endif
 
-    m_alphabet = new Alphabet();
-    if (m_alphabet->build_from_text(filename) != 0) {
+    if (create_alphabet(filename) != 0) {
         return -1;
     }
 #ifdef DEBUG
@@ -172,12 +447,15 @@ int Index::build(char const *filename) {
 
     if (file.is_open()) {
         Counter counter(words_number);
+        std::vector<size_type> cuts;
+        get_cuts(&cuts);
 
         genome_words_number = counter.build_counter(file, m_word_size,
                                                     m_shift,
                                                     m_alphabet,
                                                     m_text_length,
-                                                    m_additional_text_length);
+                                                    m_additional_text_length,
+                                                    cuts);
 #ifdef DEBUG
         print_time(start_now, "word counter time: ");
 #endif
@@ -187,10 +465,52 @@ int Index::build(char const *filename) {
 
         create_bit_vector(counter, words_number, genome_words_number);
 
+        if (m_build_qgram_table) {
+            std::vector<size_type> boundaries;
+            get_boundaries(&boundaries);
+            m_qgram_table = new QGramTable();
+            m_qgram_table->build(file, m_word_size - 1, m_alphabet, boundaries);
+#ifdef DEBUG
+            print_time(start_now, "q-gram table time: ");
+#endif
+        }
+
         create_text(filename);
-        m_permutation = create_permutation(genome_words_number);
+        m_permutation = create_permutation(genome_words_number, grid_words_number());
         counter.prepare_for_permutation();
-        create_permutation(file, counter);
+        create_permutation(file, counter, cuts);
+        complete_permutation();
+
+        if (m_build_suffix_directory) {
+            m_suffix_directory = new SuffixDirectory();
+            m_suffix_directory->build(m_directory, m_permutation, m_alphabet, m_word_size);
+        }
+
+        if (m_repeat_threshold > 0) {
+            m_repeat_buckets = new RepeatBuckets();
+            m_repeat_buckets->build(file, m_directory, m_permutation, m_alphabet,
+                                    m_word_size, m_shift, m_repeat_threshold);
+        }
+
+        if (m_pair_filter_bits > 0) {
+            m_pair_filter = new PairFilter();
+            if (m_pair_filter->build(file, m_word_size, m_shift, m_alphabet, genome_words_number,
+                                     m_pair_filter_bits) != 0) {
+                std::cerr << "Pair filter is too large, it is not stored.\n";
+                delete m_pair_filter;
+                m_pair_filter = nullptr;
+            }
+        }
+
+        if (m_colocated_leading > 0) {
+            m_colocated_directory = new ColocatedDirectory();
+            if (m_colocated_directory->build(m_directory, m_permutation, words_number,
+                                             m_colocated_leading) != 0) {
+                std::cerr << "Positions don't fit colocated directory, it is not stored.\n";
+                delete m_colocated_directory;
+                m_colocated_directory = nullptr;
+            }
+        }
 #ifdef DEBUG
         print_time(start_now, "perm and text time: ");
         print_time(start, "index build time: ");
@@ -204,9 +524,9 @@ int Index::build(char const *filename) {
     return 0;
 }
 
-template<uint8_t t_width>
-inline Index::value_type Index::inc_counter(Counter<t_width> &counter, value_type const word_value) {
-    auto sel = m_select1->select(word_value + 1);
+template<typename t_counter>
+inline Index::value_type Index::inc_counter(t_counter &counter, value_type const word_value) {
+    auto sel = m_directory->select1(word_value + 1);
     auto curr_position = rank_0(sel);
 
     return counter.get_and_inc(word_value) + curr_position;
@@ -218,13 +538,14 @@ inline Index::value_type Index::inc_counter(Counter<32> &counter, value_type con
 }
 
 template<typename Counter>
-void Index::create_permutation(std::ifstream &file, Counter &counter) {
+void Index::create_permutation(std::ifstream &file, Counter &counter, std::vector<size_type> const &cuts) {
     file.clear();
     file.seekg(0, std::ios::beg);
 
-    value_type divisor = m_alphabet->pow_wsize(m_word_size - m_shift);
+    Divisor const &divisor = m_alphabet->get_divisor(m_word_size - m_shift);
     bool additional_word = false;
     size_type position = 0;
+    size_type next_cut = 0;
     size_type word_length = 0;
     value_type word_value = 0;
 
@@ -246,9 +567,13 @@ void Index::create_permutation(std::ifstream &file, Counter &counter) {
             if (!additional_word)
                 additional_word = true;
             if (word_length == m_word_size) {
-                value_type perm_value = inc_counter(counter, word_value);
-                m_permutation->set_field(perm_value, position++);
-                word_value %= divisor;
+                // skipped words keep their index, so cells hold text positions divided by shift
+                if (!spans_cut(cuts, position * m_shift, position * m_shift + m_word_size, &next_cut)) {
+                    value_type perm_value = inc_counter(counter, word_value);
+                    m_permutation->set_field(perm_value, position);
+                }
+                ++position;
+                word_value = divisor.modulo(word_value);
                 word_length -= m_shift;
                 additional_word = false;
             }
@@ -263,8 +588,316 @@ void Index::create_permutation(std::ifstream &file, Counter &counter) {
             word_length++;
         }
 
-        value_type perm_value = inc_counter(counter, word_value);
-        m_permutation->set_field(perm_value, position);
+        if (!spans_cut(cuts, position * m_shift, m_text_length, &next_cut)) {
+            value_type perm_value = inc_counter(counter, word_value);
+            m_permutation->set_field(perm_value, position);
+        }
+    }
+}
+
+template<typename Extractor>
+int Index::count_short_kernel(std::string const &pattern, ulong length,
+                              Extractor const &extract_value, bool const locate, ulong *numocc, std::vector<ulong> *occ) const {
+    length = std::min(m_text_length, length);
+
+    if (pattern.length() >= m_word_size)
+        count_full_words(pattern, length, locate, numocc, occ, NULL);
+
+    std::vector<bool> right_side(m_shift, false);
+    plan_short(pattern, &right_side);
+
+    count_short_right(pattern, right_side, extract_value, locate, numocc, occ);
+    if (m_suffix_directory != nullptr)
+        count_short_left_suffix(pattern, right_side, extract_value, locate, numocc, occ);
+    else
+        count_short_left(pattern, right_side, extract_value, locate, numocc, occ);
+
+    add_last_occ(pattern, locate, numocc, occ);
+    add_cut_occ(pattern, right_side, extract_value, locate, numocc, occ);
+    if (!locate && !verifies_buckets()) {
+        check_occ_end(pattern, right_side, numocc);
+    }
+
+    return 0;
+}
+
+template<typename Extractor>
+int Index::count_short_left(std::string const &pattern, std::vector<bool> const &right_side,
+                            Extractor const &extract_value, bool const locate, ulong *numocc, std::vector<ulong> *occ) const {
+
+    size_type start = (ulong) std::max(0, (int) (pattern.length() - m_word_size + 1));
+
+    size_type left_index = 1;
+    value_type left_chunk_value = m_alphabet->get_word_value(pattern, 0,
+                                                        std::min(m_word_size - 1, pattern.length()));
+    if (pattern.length() < m_word_size - 1)
+        left_chunk_value *= m_alphabet->pow_wsize(m_word_size - pattern.length() - 1);
+
+    value_type right_chunk_value = 0;
+    if (m_word_size <= pattern.length())
+        right_chunk_value = m_alphabet->get_word_value(pattern, m_word_size - left_index,
+                                                       pattern.length());
+
+    Divisor const &by_size = m_alphabet->get_divisor(1);
+    value_type lowest_divisor = m_alphabet->pow_wsize(m_word_size - 1);
+    value_type multiplier = this->m_alphabet->size();
+    size_type limit = m_shift - std::max(start, (size_type) 1);
+    std::vector<value_type> positions;
+
+    for (size_type i = 0; i < limit; ++i) {
+        for (ulong k = 0; !right_side[m_shift - left_index] && k < multiplier; ++k) {
+            value_type lower_bound = get_position_in_permutation(left_chunk_value +
+                k * lowest_divisor);
+
+            if (m_word_size - left_index < pattern.length()) {
+                value_type upper_bound = get_position_in_permutation(left_chunk_value +
+                    k * lowest_divisor + 1);
+
+                decode_bucket(lower_bound, upper_bound, left_chunk_value + k * lowest_divisor,
+                              pattern, m_word_size - left_index, &positions);
+                for (ulong j = 0; j < positions.size(); ++j) {
+                    size_type word_position_index = positions[j] * m_shift;
+                    size_type right_chunk_length = pattern.length() - m_word_size + left_index;
+
+                    if (right_chunk_length > 0 &&
+                        word_position_index + m_word_size + right_chunk_length <=
+                            segment_end(word_position_index + left_index) &&
+                        right_chunk_value == extract_value(word_position_index + m_word_size,
+                                                           right_chunk_length)) {
+                        (*numocc)++;
+
+                        if (locate) {
+                            occ->push_back(word_position_index + left_index);
+                        }
+                    }
+                }
+            }
+            else {
+                value_type upper_bound = get_position_in_permutation((left_chunk_value +
+                    k * lowest_divisor) + m_alphabet->pow_wsize(m_word_size - left_index -
+                    pattern.length()));
+
+                *numocc += upper_bound - lower_bound;
+
+                if (locate || verifies_buckets()) {
+                    verify_occurrences(lower_bound, upper_bound, pattern.length(),
+                                       left_index, numocc, occ);
+                }
+            }
+        }
+
+        if (m_word_size - left_index - 1 < pattern.length())
+            right_chunk_value += m_alphabet->get_char_value(pattern[m_word_size - left_index - 1]) *
+                m_alphabet->pow_wsize(pattern.length() - m_word_size + left_index);
+
+        left_chunk_value = by_size.divide(left_chunk_value);
+        multiplier *= this->m_alphabet->size();
+        ++left_index;
+        lowest_divisor = m_alphabet->pow_wsize(m_word_size - left_index);
+    }
+
+    return 0;
+}
+
+template<typename Extractor>
+int Index::count_short_left_suffix(std::string const &pattern, std::vector<bool> const &right_side,
+                                   Extractor const &extract_value, bool const locate, ulong *numocc, std::vector<ulong> *occ) const {
+    size_type start = (ulong) std::max(0, (int) (pattern.length() - m_word_size + 1));
+    size_type limit = m_shift - std::max(start, (size_type) 1);
+
+    for (size_type left_index = 1; left_index <= limit; ++left_index) {
+        if (right_side[m_shift - left_index])
+            continue;
+
+        size_type suffix_length = std::min(m_word_size - left_index, (size_type) pattern.length());
+        size_type tail_length = m_word_size - left_index - suffix_length;
+        value_type range_size = m_alphabet->pow_wsize(left_index);
+
+        // pattern lies inside the word and the words sharing its prefix are fewer than
+        // those sharing its suffix, enumerate them in the main directory
+        if (tail_length > left_index) {
+            value_type word_value = m_alphabet->get_word_value(pattern) *
+                m_alphabet->pow_wsize(tail_length);
+            value_type divisor = m_alphabet->pow_wsize(m_word_size - left_index);
+            value_type bound = m_alphabet->pow_wsize(tail_length);
+
+            for (value_type k = 0; k < range_size; ++k) {
+                value_type lower_bound = get_position_in_permutation(word_value + k * divisor);
+                value_type upper_bound = get_position_in_permutation(word_value + k * divisor + bound);
+
+                *numocc += upper_bound - lower_bound;
+
+                if (locate || verifies_buckets()) {
+                    verify_occurrences(lower_bound, upper_bound, pattern.length(),
+                                       left_index, numocc, occ);
+                }
+            }
+
+            continue;
+        }
+
+        // words ending with pattern[0, suffix_length) followed by any tail of tail_length
+        value_type suffix_value = m_alphabet->get_reversed_word_value(pattern, 0, suffix_length);
+        value_type suffix_multiplier = m_alphabet->pow_wsize(suffix_length);
+        value_type tails_number = m_alphabet->pow_wsize(tail_length);
+
+        size_type right_chunk_length = pattern.length() - suffix_length;
+        value_type right_chunk_value = m_alphabet->get_word_value(pattern, suffix_length,
+                                                                  pattern.length());
+
+        for (value_type k = 0; k < tails_number; ++k) {
+            value_type reversed_value = (k * suffix_multiplier + suffix_value) * range_size;
+            value_type lower_bound = m_suffix_directory->get_position(reversed_value);
+            value_type upper_bound = m_suffix_directory->get_position(reversed_value + range_size);
+
+            if (right_chunk_length > 0) {
+                for (ulong j = lower_bound; j < upper_bound; ++j) {
+                    size_type word_position_index = m_suffix_directory->pi(j) * m_shift;
+
+                    if (word_position_index + m_word_size + right_chunk_length <=
+                            segment_end(word_position_index + left_index) &&
+                        right_chunk_value == extract_value(word_position_index + m_word_size,
+                                                           right_chunk_length)) {
+                        (*numocc)++;
+
+                        if (locate) {
+                            occ->push_back(word_position_index + left_index);
+                        }
+                    }
+                }
+            }
+            else {
+                *numocc += upper_bound - lower_bound;
+
+                if (locate || verifies_buckets()) {
+                    for (ulong j = lower_bound; j < upper_bound; ++j) {
+                        size_type word_position = m_suffix_directory->pi(j) * m_shift + left_index;
+
+                        if (word_position + pattern.length() <= segment_end(word_position)) {
+                            if (locate)
+                                occ->push_back(word_position);
+                        }
+                        else {
+                            --(*numocc);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+template<typename Extractor>
+int Index::count_short_right(std::string const &pattern, std::vector<bool> const &right_side,
+                             Extractor const &extract_value, bool const locate, ulong *numocc, std::vector<ulong> *occ) const {
+    size_type start = (ulong) std::max(0, (int) (pattern.length() - m_word_size + 1));
+    value_type left_side_value = m_alphabet->get_word_value(pattern, 0, start);
+    value_type right_window_value = m_alphabet->get_word_value(pattern, start,
+                                                          pattern.length());
+
+    if (start + m_word_size > pattern.length()) {
+        right_window_value *= m_alphabet->pow_wsize(start + m_word_size -
+            pattern.length());
+    }
+
+    size_type limit = std::min(m_shift, (size_type) pattern.length());
+    Divisor const &divisor = m_alphabet->get_divisor(m_word_size - 1);
+    std::vector<value_type> positions;
+
+    for (size_type i = start; i < limit; ++i) {
+        value_type right_window_value_bound = right_window_value +
+            m_alphabet->pow_wsize(i + m_word_size - pattern.length());
+
+        value_type lower_bound = 0, upper_bound = 0;
+        if (right_side[i]) {
+            lower_bound = get_position_in_permutation(right_window_value);
+            upper_bound = get_position_in_permutation(right_window_value_bound);
+        }
+
+        if (i == 0) {
+            *numocc += upper_bound - lower_bound;
+
+            if (locate || verifies_buckets()) {
+                verify_occurrences(lower_bound, upper_bound, pattern.length(),
+                                   0, numocc, occ);
+            }
+        }
+        else {
+            m_permutation->decode_range(lower_bound, upper_bound, &positions);
+            for (ulong j = 0; j < positions.size(); ++j) {
+                size_type word_position_index = positions[j] * m_shift;
+
+                if (word_position_index >= i &&
+                    word_position_index + i <= m_text_length + 1 &&
+                    left_side_value == extract_value(word_position_index - i, i) &&
+                    in_segment(word_position_index - i, pattern.length())) {
+                    ++(*numocc);
+
+                    if (locate) {
+                        occ->push_back(word_position_index - i);
+                    }
+                }
+
+            }
+        }
+
+        right_window_value = divisor.modulo(right_window_value);
+        right_window_value *= m_alphabet->size();
+        left_side_value *= m_alphabet->size();
+        left_side_value += m_alphabet->get_char_value(pattern[i]);
+    }
+
+    return 0;
+}
+
+template<typename Extractor>
+void Index::add_cut_occ(std::string const &pattern, std::vector<bool> const &right_side,
+                        Extractor const &extract_value, bool const locate,
+                        ulong *numocc, std::vector<ulong> *occ) const {
+    if (m_masked_runs == nullptr || !skips_cut_words() || pattern.empty())
+        return;
+
+    size_type length = pattern.length();
+    size_type head_length = std::min(length, m_word_size);
+    value_type head_value = m_alphabet->get_word_value(pattern, 0, head_length);
+    value_type tail_value = m_alphabet->get_word_value(pattern, head_length, length);
+    size_type words_end = grid_words_number() * m_shift;
+
+    for (size_type run = 0; run < m_masked_runs->size(); ++run) {
+        size_type cut = m_masked_runs->get_cut(run);
+        size_type previous_cut = run > 0 ? m_masked_runs->get_cut(run - 1) : 0;
+        if (cut == 0 || cut >= m_text_length)
+            continue;
+
+        // a skipped word starts in (cut - m_word_size, cut), the occurrence chosen by it
+        // less than m_shift before or after that
+        size_type position = cut + 1 > m_word_size + m_shift ? cut + 1 - m_word_size - m_shift : 0;
+        for (; position < cut + m_shift && position + length <= m_text_length; ++position) {
+            size_type i = (m_shift - position % m_shift) % m_shift;
+            // alignments holding a whole word are found by count_full_words
+            if (i + m_word_size <= length)
+                continue;
+
+            // the word is counted at the first cut it spans, words past the last one
+            // are left to add_last_occ
+            size_type word_position = right_side[i] ? position + i : position + i - m_shift;
+            if (word_position >= cut || word_position + m_word_size <= cut ||
+                word_position < previous_cut || word_position >= words_end)
+                continue;
+
+            if (head_value != extract_value(position, head_length) ||
+                (head_length < length && tail_value != extract_value(position + head_length,
+                                                                     length - head_length)) ||
+                position + length > segment_end(position))
+                continue;
+
+            ++(*numocc);
+            if (locate) {
+                occ->push_back(position);
+            }
+        }
     }
 }
 
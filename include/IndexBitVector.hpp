@@ -27,53 +27,88 @@ class IndexBitVector : public Index {
  public:
   static uint const INDEX_TYPE;
 
-  IndexBitVector() : Index() {};
+  IndexBitVector() : Index(), m_text(nullptr), m_shared_text(false) {};
   IndexBitVector(size_type word_size, size_type shift);
+  // index over a text owned by another index, the text is neither built nor saved
+  IndexBitVector(size_type word_size, size_type shift, sdsl::int_vector<> *shared_text);
   IndexBitVector(size_type word_size, size_type shift, size_type text_length,
-                 size_type additional_text_length, sdsl::bit_vector *bit_vector,
-                 sdsl::bit_vector::rank_1_type *m_rank1,
-                 sdsl::bit_vector::select_1_type *m_select1,
+                 size_type additional_text_length, BucketDirectory *directory,
                  Permutation *permutation, Alphabet *alphabet, sdsl::int_vector<> *text);
   ~IndexBitVector();
 
-  int extract(const ulong from, const ulong to, std::string *text, ulong *length) const;
-  int save_index(std::ostream& out) const;
-  void load(std::istream& in);
-
   double get_size_in_mega_bytes() const;
 
- private:
+ protected:
 
   /*********   FUNCTIONS  ********/
 
+  uint get_index_type() const {
+      return INDEX_TYPE;
+  }
+  void save_text(std::ostream& out) const;
+  void load_text(std::istream& in);
+
+  int extract_text(const ulong from, const ulong to, std::string *text, ulong *length) const;
   value_type extract_value(size_type const from, size_type const length) const;
+  template<uint t_sigma>
+  value_type extract_packed_value(size_type const from, size_type const length) const;
 
+  int count_short(std::string const &pattern, ulong length,
+                  bool const locate, ulong *numocc, std::vector<ulong> *occ) const;
   int count_full_words(std::string const &pattern, ulong length,
-                       bool const locate, ulong *numocc, std::vector<ulong> *occ) const;
+                       bool const locate, ulong *numocc, std::vector<ulong> *occ,
+                       Slice const *slice) const;
 
   bool check_word(size_type const position, size_type const length, const char *pattern) const;
 
+  void prefetch_text(size_type const position) const {
+      if (m_text != nullptr)
+          __builtin_prefetch(m_text->data() + ((position * m_text->width()) >> 6));
+  }
+
   void create_text(char const *const filename);
   void fill_text(size_type const idx, value_type const value);
 
   /**********  FIELDS  ***********/
   sdsl::int_vector<> *m_text;
+  bool m_shared_text;
 };
 
 inline double IndexBitVector::get_size_in_mega_bytes() const {
     double result = Index::get_size_in_mega_bytes();
-    result += sdsl::size_in_mega_bytes(*m_text);
+    if (!m_shared_text && m_text != nullptr)
+        result += sdsl::size_in_mega_bytes(*m_text);
+
+    return result;
+}
+
+// t_sigma != 0 fixes the alphabet size at compile time, for 4 letters the
+// multiplication becomes a shift
+template<uint t_sigma>
+inline IndexBitVector::value_type IndexBitVector::extract_packed_value(size_type const from,
+                                                                       size_type const length) const {
+    value_type const sigma = t_sigma != 0 ? t_sigma : m_alphabet->size();
+    value_type result = 0;
+
+    for (size_type i = from; i < from + length; ++i) {
+        result *= sigma;
+        result += (*m_text)[i];
+    }
 
     return result;
 }
 
 inline void IndexBitVector::create_text(char const *const) {
+    if (m_shared_text)
+        return;
+
     m_text = new sdsl::int_vector<>(m_text_length + m_additional_text_length,
                                     0, (uint8_t) cds_utils::bits((uint) (m_alphabet->size() - 1)));
 }
 
 inline void IndexBitVector::fill_text(size_type const idx, value_type const value) {
-    (*m_text)[idx] = value;
+    if (!m_shared_text)
+        (*m_text)[idx] = value;
 }
 
 }
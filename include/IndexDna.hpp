@@ -0,0 +1,134 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#ifndef _INDEXDNA_H
+#define _INDEXDNA_H
+
+#include "Index.hpp"
+
+namespace cdat {
+
+/*
+ * Index for texts over A, C, G and T. Alphabet size is fixed to 4, the text
+ * is packed two bits per base with the first base in the most significant
+ * bits, so values of up to 32 bases are read with a shift and a mask.
+ */
+class IndexDna : public Index {
+
+ public:
+  static uint const INDEX_TYPE;
+
+  IndexDna() : Index(), m_text(nullptr) {};
+  IndexDna(size_type word_size, size_type shift);
+  IndexDna(size_type word_size, size_type shift, size_type text_length,
+           size_type additional_text_length, BucketDirectory *directory,
+           Permutation *permutation, Alphabet *alphabet, sdsl::int_vector<64> *text);
+  ~IndexDna();
+
+  double get_size_in_mega_bytes() const;
+
+ private:
+
+  /*********   FUNCTIONS  ********/
+
+  uint get_index_type() const {
+      return INDEX_TYPE;
+  }
+  void save_text(std::ostream& out) const;
+  void load_text(std::istream& in);
+
+  int extract_text(const ulong from, const ulong to, std::string *text, ulong *length) const;
+
+  static size_type const BASES_PER_WORD = 32;
+
+  static value_type packed_value(uint64_t const *data, size_type const from, size_type const length);
+  static void pack_pattern(std::string const &pattern, Alphabet const *alphabet,
+                           std::vector<uint64_t> *packed);
+
+  value_type extract_value(size_type const from, size_type const length) const;
+
+  int count_short(std::string const &pattern, ulong length,
+                  bool const locate, ulong *numocc, std::vector<ulong> *occ) const;
+  int count_full_words(std::string const &pattern, ulong length,
+                       bool const locate, ulong *numocc, std::vector<ulong> *occ,
+                       Slice const *slice) const;
+
+  bool check_word(size_type const position, size_type const length,
+                  std::vector<uint64_t> const &pattern, size_type const pattern_position) const;
+
+  void prefetch_text(size_type const position) const {
+      if (m_text != nullptr)
+          __builtin_prefetch(m_text->data() + position / BASES_PER_WORD);
+  }
+
+  int create_alphabet(char const *filename);
+  void create_text(char const *const filename);
+  void fill_text(size_type const idx, value_type const value);
+
+  /**********  FIELDS  ***********/
+  sdsl::int_vector<64> *m_text;
+};
+
+// length <= BASES_PER_WORD, data has to be padded with one word after the last base
+inline IndexDna::value_type IndexDna::packed_value(uint64_t const *data, size_type const from,
+                                                   size_type const length) {
+    if (length == 0)
+        return 0;
+
+    size_type bit = 2 * from;
+    size_type offset = bit & 63;
+    uint64_t value = data[bit >> 6] << offset;
+    if (offset + 2 * length > 64)
+        value |= data[(bit >> 6) + 1] >> (64 - offset);
+
+    return value >> (64 - 2 * length);
+}
+
+inline IndexDna::value_type IndexDna::extract_value(size_type const from,
+                                                    size_type const length) const {
+    value_type result = 0;
+    size_type start = from;
+    size_type to = from + length;
+
+    while (start < to) {
+        size_type chunk = std::min(BASES_PER_WORD, to - start);
+        // shift in two steps, a single shift by 64 bits is undefined
+        result = (result << (2 * chunk - 1) << 1) | packed_value(m_text->data(), start, chunk);
+        start += chunk;
+    }
+
+    return result;
+}
+
+inline double IndexDna::get_size_in_mega_bytes() const {
+    double result = Index::get_size_in_mega_bytes();
+    if (m_text != nullptr)
+        result += sdsl::size_in_mega_bytes(*m_text);
+
+    return result;
+}
+
+inline void IndexDna::create_text(char const *const) {
+    m_text = new sdsl::int_vector<64>((m_text_length + m_additional_text_length) / BASES_PER_WORD + 2, 0);
+}
+
+inline void IndexDna::fill_text(size_type const idx, value_type const value) {
+    m_text->data()[idx / BASES_PER_WORD] |= value << (62 - 2 * (idx % BASES_PER_WORD));
+}
+
+}
+#endif
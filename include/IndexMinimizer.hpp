@@ -0,0 +1,179 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+
+#ifndef _INDEXMINIMIZER_H
+#define _INDEXMINIMIZER_H
+
+#include "Index.hpp"
+
+namespace cdat {
+
+/*
+ * Index sampling (w, k)-minimizers instead of every shift-th word. For every
+ * window of w consecutive words of length k the word with the smallest hash
+ * is sampled (the leftmost one on ties), windows at the end of the text are
+ * shortened. Buckets keep text positions of the sampled words, m_shift holds w.
+ *
+ * Pattern of at least w + k - 1 characters contains a whole window, so its
+ * minimizer is sampled in every occurrence and a single bucket is verified.
+ * Occurrences of patterns shorter than w may hold no sampled word, those
+ * patterns are answered by a linear scan of the text.
+ */
+class IndexMinimizer : public Index {
+
+ public:
+  static uint const INDEX_TYPE;
+
+  IndexMinimizer() : Index(), m_text(nullptr) {};
+  IndexMinimizer(size_type word_size, size_type window);
+  ~IndexMinimizer();
+
+  int build(char const *filename);
+  double get_size_in_mega_bytes() const;
+
+  // only the bucket of the pattern minimizer is scanned, patterns are not split
+  bool split_query(std::string const &, size_type const, std::vector<Slice> *slices) const {
+      slices->clear();
+      return false;
+  }
+
+ private:
+
+  /*********   FUNCTIONS  ********/
+
+  uint get_index_type() const {
+      return INDEX_TYPE;
+  }
+  // minimizers spanning cuts are kept, their candidates are checked against the cuts
+  bool skips_cut_words() const {
+      return false;
+  }
+  void save_text(std::ostream& out) const;
+  void load_text(std::istream& in);
+
+  int extract_text(const ulong from, const ulong to, std::string *text, ulong *length) const;
+
+  static value_type word_order(value_type const word_value);
+
+  template<typename Callback>
+  void for_each_minimizer(Callback const &callback) const;
+  size_type window_minimizer(size_type const position) const;
+  size_type pattern_minimizer(std::string const &pattern) const;
+
+  value_type extract_value(size_type const from, size_type const length) const;
+  size_type sampled_position(value_type const idx) const;
+
+  int count_short(std::string const &pattern, ulong length,
+                  bool const locate, ulong *numocc, std::vector<ulong> *occ) const;
+  int count_full_words(std::string const &pattern, ulong length,
+                       bool const locate, ulong *numocc, std::vector<ulong> *occ,
+                       Slice const *slice) const;
+  void count_scan(std::string const &pattern, size_type const from, size_type const to,
+                  bool const locate, ulong *numocc, std::vector<ulong> *occ) const;
+
+  bool check_word(size_type const position, size_type const length, const char *pattern) const;
+
+  /**********  FIELDS  ***********/
+  sdsl::int_vector<> *m_text;
+};
+
+// bijective mix of the word value, so words with common prefixes are not
+// sampled together and distinct words never tie
+inline IndexMinimizer::value_type IndexMinimizer::word_order(value_type const word_value) {
+    value_type result = word_value;
+    result ^= result >> 33;
+    result *= 0xff51afd7ed558ccdULL;
+    result ^= result >> 33;
+    result *= 0xc4ceb9fe1a85ec53ULL;
+    result ^= result >> 33;
+
+    return result;
+}
+
+// calls callback(position, word_value) for every sampled word in increasing
+// order of positions, each position once
+template<typename Callback>
+void IndexMinimizer::for_each_minimizer(Callback const &callback) const {
+    if (m_text_length < m_word_size)
+        return;
+
+    size_type last_word = m_text_length - m_word_size;
+    Divisor const &words = m_alphabet->get_divisor(m_word_size);
+    value_type word_value = extract_value(0, m_word_size - 1);
+
+    // ring buffer of window words with increasing order, front is the minimizer
+    size_type const capacity = m_shift + 1;
+    Divisor const ring(capacity);
+    std::vector<size_type> positions(capacity);
+    std::vector<value_type> values(capacity);
+    std::vector<value_type> orders(capacity);
+    size_type front = 0, back = 0;
+    size_type previous = last_word + 1;
+
+    for (size_type j = 0; j <= last_word + m_shift - 1; ++j) {
+        if (j <= last_word) {
+            word_value = words.modulo(word_value * m_alphabet->size() + (*m_text)[j + m_word_size - 1]);
+            value_type order = word_order(word_value);
+
+            while (back > front && orders[ring.modulo(back - 1)] > order)
+                --back;
+            positions[ring.modulo(back)] = j;
+            values[ring.modulo(back)] = word_value;
+            orders[ring.modulo(back++)] = order;
+        }
+
+        if (j + 1 < m_shift)
+            continue;
+
+        size_type window_start = j + 1 - m_shift;
+        while (positions[ring.modulo(front)] < window_start)
+            ++front;
+
+        if (positions[ring.modulo(front)] != previous) {
+            previous = positions[ring.modulo(front)];
+            callback(previous, values[ring.modulo(front)]);
+        }
+    }
+}
+
+inline IndexMinimizer::value_type IndexMinimizer::extract_value(size_type const from,
+                                                                size_type const length) const {
+    value_type result = 0;
+
+    for (size_type i = from; i < from + length; ++i) {
+        result *= m_alphabet->size();
+        result += (*m_text)[i];
+    }
+
+    return result;
+}
+
+inline IndexMinimizer::size_type IndexMinimizer::sampled_position(value_type const idx) const {
+    return idx;
+}
+
+inline double IndexMinimizer::get_size_in_mega_bytes() const {
+    double result = Index::get_size_in_mega_bytes();
+    if (m_text != nullptr)
+        result += sdsl::size_in_mega_bytes(*m_text);
+
+    return result;
+}
+
+}
+#endif
@@ -20,6 +20,7 @@
 
 #include "Index.hpp"
 #include "RevPermutation.hpp"
+#include "SampledRevPermutation.hpp"
 
 namespace cdat {
 
@@ -28,43 +29,79 @@ class IndexPerm : public Index {
  public:
   static const uint INDEX_TYPE;
 
-  IndexPerm() : Index() {};
+  IndexPerm() : Index(), m_inverse_sampling(0) {};
   IndexPerm(size_type word_size, size_type shift);
   IndexPerm(size_type word_size, size_type shift, size_type text_length,
-            size_type additional_text_length, sdsl::bit_vector *bit_vector,
-            sdsl::bit_vector::rank_1_type *rank1,
-            sdsl::bit_vector::select_0_type *select0,
-            sdsl::bit_vector::select_1_type *select1,
+            size_type additional_text_length, BucketDirectory *directory,
             Permutation *permutation, Alphabet *alphabet);
   ~IndexPerm();
 
-  int extract(const ulong from, const ulong to, std::string *text, ulong *length) const;
-  int save_index(std::ostream& out) const;
-  void load(std::istream& in);
+  // 0 keeps the whole inverse permutation, otherwise every inverse lookup
+  // follows at most about 2 * sampling values of the permutation
+  void set_inverse_sampling(size_type const sampling) {
+      m_inverse_sampling = sampling;
+  }
 
  private:
 
+  uint get_index_type() const {
+      return INDEX_TYPE;
+  }
+  // the text is read back from the permutation, so words spanning cuts are kept
+  bool skips_cut_words() const {
+      return false;
+  }
+  void save_core(std::ostream& out) const;
+  void load_core(std::istream& in);
+  Permutation *load_permutation(std::istream &in) const;
+
+  int extract_text(const ulong from, const ulong to, std::string *text, ulong *length) const;
   value_type extract_value(size_type const from, size_type const length) const;
+  template<class t_permutation>
+  value_type extract_value_kernel(size_type const from, size_type const length) const;
+  template<class t_permutation>
+  value_type word_value_at(size_type const perm_position) const;
 
+  int count_short(std::string const &pattern, ulong length,
+                  bool const locate, ulong *numocc, std::vector<ulong> *occ) const;
   int count_full_words(std::string const &pattern, ulong length,
-                       bool const locate, ulong *numocc, std::vector<ulong> *occ) const;
+                       bool const locate, ulong *numocc, std::vector<ulong> *occ,
+                       Slice const *slice) const;
+  template<class t_permutation>
+  int count_full_words_kernel(std::string const &pattern, ulong length,
+                              bool const locate, ulong *numocc, std::vector<ulong> *occ,
+                              Slice const *slice) const;
 
   void count_right_side_values(
       std::vector<std::pair<size_t, uint> > &right_side_values,
       std::string const &pattern) const;
 
+  template<class t_permutation>
   bool check_and_extract_value(size_type  const position, size_type  const array_size,
                                std::vector<std::pair<size_t, uint> > const &right_side_values) const;
 
   std::string get_word(size_type const start, size_type const length) const;
 
-  Permutation *create_permutation(size_type const size) const;
-  virtual void create_bit_vector_support();
+  Permutation *create_permutation(size_type const size, size_type const sampled_words) const;
+  virtual void create_bit_vector_support(sdsl::bit_vector const &bit_vector);
+  virtual void complete_permutation();
 
-  sdsl::bit_vector::select_0_type *m_select0;
+  size_type m_inverse_sampling;
 };
 
-inline Permutation *IndexPerm::create_permutation(size_type const size) const {
+// t_permutation is the concrete type of m_permutation, so revpi can be inlined
+template<class t_permutation>
+inline IndexPerm::value_type IndexPerm::word_value_at(size_type const perm_position) const {
+    value_type word_value = static_cast<t_permutation const *>(m_permutation)->
+        t_permutation::revpi(perm_position) + 1;
+
+    return m_directory->rank1(m_directory->select0(word_value)) - 1;
+}
+
+inline Permutation *IndexPerm::create_permutation(size_type const size, size_type const) const {
+    if (m_inverse_sampling > 0)
+        return new Permutation(size);
+
     return new RevPermutation(size);
 }
 
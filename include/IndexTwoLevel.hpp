@@ -0,0 +1,114 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+
+#ifndef _INDEXTWOLEVEL_H
+#define _INDEXTWOLEVEL_H
+
+#include "IndexBitVector.hpp"
+
+namespace cdat {
+
+/*
+ * Bit vector index with a second level of longer words over the same text.
+ * Patterns of at least long_word_size + long_shift - 1 characters are searched
+ * in the long level with small buckets, shorter ones in the short level.
+ */
+class IndexTwoLevel : public IndexBitVector {
+
+ public:
+  static uint const INDEX_TYPE;
+
+  IndexTwoLevel() : IndexBitVector(), m_long_index(nullptr), m_long_word_size(0), m_long_shift(0) {};
+  IndexTwoLevel(size_type word_size, size_type shift,
+                size_type long_word_size, size_type long_shift);
+  ~IndexTwoLevel();
+
+  template<typename Counter>
+  int build(char const *filename);
+
+  double get_size_in_mega_bytes() const;
+  // short level with the text, long level without it
+  double get_short_size_in_mega_bytes() const;
+  double get_long_size_in_mega_bytes() const;
+
+  // long patterns are split by the long level
+  bool split_query(std::string const &pattern, size_type const max_cells,
+                   std::vector<Slice> *slices) const;
+
+  // nullptr until the text section of a mapped index is read
+  IndexBitVector const *get_long_index() const {
+      return m_long_index;
+  }
+
+  size_type get_long_word_size() const {
+      return m_long_word_size;
+  }
+
+  size_type get_long_shift() const {
+      return m_long_shift;
+  }
+
+ private:
+
+  /*********   FUNCTIONS  ********/
+
+  uint get_index_type() const {
+      return INDEX_TYPE;
+  }
+  void save_core(std::ostream& out) const;
+  void load_core(std::istream& in);
+  void save_text(std::ostream& out) const;
+  void load_text(std::istream& in);
+
+  int count_full_words(std::string const &pattern, ulong length,
+                       bool const locate, ulong *numocc, std::vector<ulong> *occ,
+                       Slice const *slice) const;
+
+  /**********  FIELDS  ***********/
+  IndexBitVector *m_long_index;
+  size_type m_long_word_size;
+  size_type m_long_shift;
+};
+
+template<typename Counter>
+int IndexTwoLevel::build(char const *filename) {
+    if (Index::build<Counter>(filename) != 0)
+        return -1;
+
+    m_long_index = new IndexBitVector(m_long_word_size, m_long_shift, m_text);
+    m_long_index->set_directory_type(m_directory_type);
+    m_long_index->set_repeat_threshold(m_repeat_threshold);
+    m_long_index->share_boundaries(this);
+
+    return m_long_index->build<Counter>(filename);
+}
+
+inline double IndexTwoLevel::get_size_in_mega_bytes() const {
+    return get_short_size_in_mega_bytes() + get_long_size_in_mega_bytes();
+}
+
+inline double IndexTwoLevel::get_short_size_in_mega_bytes() const {
+    return IndexBitVector::get_size_in_mega_bytes();
+}
+
+inline double IndexTwoLevel::get_long_size_in_mega_bytes() const {
+    return m_long_index != nullptr ? m_long_index->get_size_in_mega_bytes() : 0;
+}
+
+}
+#endif
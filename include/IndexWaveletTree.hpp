@@ -19,8 +19,7 @@
 #define _INDEXWAVELETTREE_H
 
 #include "Index.hpp"
-
-#include <sdsl/wavelet_trees.hpp>
+#include "WaveletText.hpp"
 
 
 namespace cdat {
@@ -30,54 +29,82 @@ class IndexWaveletTree : public Index {
  public:
   static const uint INDEX_TYPE;
 
-  IndexWaveletTree() : Index() {};
+  IndexWaveletTree() : Index(), m_text(nullptr), m_text_type(WaveletText::HUFFMAN) {};
   IndexWaveletTree(size_type word_size, size_type shift);
   IndexWaveletTree(size_type word_size, size_type shift, size_type text_length,
-                   size_type additional_text_length, sdsl::bit_vector *bit_vector,
-                   sdsl::bit_vector::rank_1_type *rank1,
-                   sdsl::bit_vector::select_1_type *select1,
-                   Permutation *permutation, Alphabet *alphabet,
-                   sdsl::wt_huff<sdsl::bit_vector, sdsl::rank_support_v<>,
-                                 sdsl::select_support_scan<>, sdsl::select_support_scan<> > *text);
+                   size_type additional_text_length, BucketDirectory *directory,
+                   Permutation *permutation, Alphabet *alphabet, WaveletText *text);
 
   ~IndexWaveletTree();
 
-  int extract(const ulong from, const ulong to, std::string *text, ulong *length) const;
-  int save_index(std::ostream& out) const;
-  void load(std::istream& in);
-
   double get_size_in_mega_bytes() const;
 
+  // wavelet structure storing the text, see WaveletText
+  void set_text_type(uint const type) {
+      m_text_type = type;
+  }
+
+  WaveletText const *get_text() const {
+      return m_text;
+  }
+
  private:
 
   /*********   FUNCTIONS  ********/
 
-  value_type extract_value(size_type const from, size_type const length) const;
+  uint get_index_type() const {
+      return INDEX_TYPE;
+  }
+  void save_text(std::ostream& out) const;
+  void load_text(std::istream& in);
 
-  int count_full_words(std::string const &pattern, ulong length,
+  int extract_text(const ulong from, const ulong to, std::string *text, ulong *length) const;
+  value_type extract_value(size_type const from, size_type const length) const;
+  template<class t_text>
+  value_type extract_value_kernel(size_type const from, size_type const length) const;
+  template<class t_text>
+  unsigned char text_at(size_type const idx) const;
+
+  int count_short(std::string const &pattern, ulong length,
+                  bool const locate, ulong *numocc, std::vector<ulong> *occ) const;
+  template<class t_text>
+  int count_short_text(std::string const &pattern, ulong length,
                        bool const locate, ulong *numocc, std::vector<ulong> *occ) const;
-
+  int count_full_words(std::string const &pattern, ulong length,
+                       bool const locate, ulong *numocc, std::vector<ulong> *occ,
+                       Slice const *slice) const;
+  template<class t_text>
+  int count_full_words_kernel(std::string const &pattern, ulong length,
+                              bool const locate, ulong *numocc, std::vector<ulong> *occ,
+                              Slice const *slice) const;
+
+  template<class t_text>
   bool check_word(size_type const position, size_type const length, const char *pattern) const;
 
   void create_text(char const *const filename);
 
   /**********  FIELDS  ***********/
-  sdsl::wt_huff<sdsl::bit_vector, sdsl::rank_support_v<>,
-                sdsl::select_support_scan<>, sdsl::select_support_scan<> > *m_text;
+  WaveletText *m_text;
+  uint m_text_type;
 
 };
 
 inline double IndexWaveletTree::get_size_in_mega_bytes() const {
     double result = Index::get_size_in_mega_bytes();
-    result += sdsl::size_in_mega_bytes(*m_text);
+    if (m_text != nullptr)
+        result += m_text->size_in_mega_bytes();
 
     return result;
 }
 
 inline void IndexWaveletTree::create_text(char const *const filename) {
-    m_text = new sdsl::wt_huff<sdsl::bit_vector, sdsl::rank_support_v<>,
-                               sdsl::select_support_scan<>, sdsl::select_support_scan<> >();
-    construct(*m_text, filename, 1);
+    m_text = WaveletText::create(m_text_type, filename);
+}
+
+// t_text is the concrete type of m_text, so access is not a virtual call
+template<class t_text>
+inline unsigned char IndexWaveletTree::text_at(size_type const idx) const {
+    return static_cast<t_text const *>(m_text)->get_wavelet_tree()[idx];
 }
 
 }
@@ -0,0 +1,77 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+
+#ifndef _MAPPEDFILE_H
+#define _MAPPEDFILE_H
+
+#include <stdint.h>
+#include <streambuf>
+
+namespace cdat {
+
+/*
+ * Read only mapping of a whole file. Pages are shared through the page cache
+ * by all processes mapping the same index.
+ */
+class MappedFile {
+ public:
+  typedef uint64_t size_type;
+
+  MappedFile() : m_data(nullptr), m_size(0) {};
+  ~MappedFile();
+
+  int open(char const *filename);
+
+  char const *data() const {
+      return m_data;
+  }
+
+  size_type size() const {
+      return m_size;
+  }
+
+ private:
+  char *m_data;
+  size_type m_size;
+};
+
+/*
+ * Stream buffer reading a mapped file. Loaders reach the mapped bytes through
+ * position(), so aligned arrays can be used in place instead of copied.
+ */
+class MappedBuffer : public std::streambuf {
+ public:
+  typedef uint64_t size_type;
+
+  MappedBuffer(char const *data, size_type const size);
+
+  char const *position() const {
+      return gptr();
+  }
+
+  void skip(size_type const bytes) {
+      setg(eback(), gptr() + bytes, egptr());
+  }
+
+ protected:
+  pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode);
+  pos_type seekpos(pos_type position, std::ios_base::openmode mode);
+};
+
+}
+#endif
@@ -0,0 +1,81 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+#ifndef _MAPPER_H
+#define _MAPPER_H
+
+#include "Index.hpp"
+
+#include <string>
+#include <vector>
+
+namespace cdat {
+
+/*
+ * Read mapping on top of an index: seeds of size + shift - 1 characters are
+ * located exactly, chained when they lie colinear on nearly the same diagonal,
+ * and the best chains are extended with a bit-parallel edit distance kernel
+ * over a band of the stored text around their diagonal.
+ *
+ * Seeds are taken at a stride such that any read within max_distance of the
+ * text keeps one of them unedited, as long as its error-free runs of
+ * (length - max_distance) / (max_distance + 1) characters hold a seed.
+ */
+class Mapper {
+ public:
+  typedef uint64_t size_type;
+
+  // text range [position, position + length) aligned with the read
+  struct Hit {
+    size_type position;
+    size_type length;
+    size_type distance;
+  };
+
+  // seeds whose leading word has more than MAX_SEED_HITS positions are skipped unless no seed has fewer,
+  // at most MAX_CANDIDATES best chains are extended and MAX_PREDECESSORS looked back at
+  static size_type const MAX_SEED_HITS = 1 << 10;
+  static size_type const MAX_CANDIDATES = 32;
+  static size_type const MAX_PREDECESSORS = 32;
+
+  Mapper(Index const *index, size_type const max_distance) : m_index(index), m_max_distance(max_distance) {};
+
+  // hits with the smallest edit distance up to max_distance ordered by position, -1 for
+  // indexes with masked runs, whose text can't be read in the original coordinates
+  int map(std::string const &read, std::vector<Hit> *hits) const;
+
+  // smallest edit distance of pattern to a substring of text, which ends at *end (exclusive,
+  // the first such end) and starts at text[0] if anchored; Myers' bit-vector algorithm
+  // computes 64 rows of the matrix per word
+  static size_type edit_distance(std::string const &pattern, char const *text, size_type const length,
+                                 bool const anchored, size_type *end);
+
+ private:
+  struct Anchor {
+    size_type position;
+    size_type offset;
+  };
+
+  void collect_anchors(std::string const &read, std::vector<Anchor> *anchors) const;
+  void chain_anchors(std::vector<Anchor> const &anchors, std::vector<Anchor> *candidates) const;
+  bool extend(std::string const &read, Anchor const &anchor, Hit *hit) const;
+
+  Index const *m_index;
+  size_type m_max_distance;
+};
+
+}
+#endif
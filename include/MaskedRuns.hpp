@@ -0,0 +1,87 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+
+#ifndef _MASKEDRUNS_H
+#define _MASKEDRUNS_H
+
+#include <libcds/libcdsBasics.h>
+
+#include <string>
+#include <vector>
+
+#include <sdsl/bit_vectors.hpp>
+
+namespace cdat {
+
+/*
+ * Runs of masked characters (N blocks) cut out of the indexed text, see
+ * replace_dna -r. For every run keeps the position of the cut in the indexed
+ * text and the number of characters removed before it, which maps indexed
+ * positions back to the original text.
+ */
+class MaskedRuns {
+ public:
+  typedef uint64_t size_type;
+
+  static char const MASK_CHAR = 'N';
+
+  MaskedRuns() {};
+
+  // reads lines "position length" of the original text, sorted by position
+  int build(char const *filename);
+
+  size_type to_original(size_type const position) const;
+  // position of the indexed text holding original position, the cut for positions inside a run
+  size_type to_indexed(size_type const position) const;
+  // number of cuts at or before position of the indexed text
+  size_type cuts_until(size_type const position) const;
+
+  size_type size() const {
+      return m_cuts.size();
+  }
+
+  size_type get_cut(size_type const run) const {
+      return m_cuts[run];
+  }
+
+  size_type original_start(size_type const run) const {
+      return m_cuts[run] + m_removed[run];
+  }
+
+  size_type original_end(size_type const run) const {
+      return m_cuts[run] + m_removed[run + 1];
+  }
+
+  size_type removed_before(size_type const run) const {
+      return m_removed[run];
+  }
+
+  // first run ending after original position
+  size_type find_run(size_type const position) const;
+
+  static MaskedRuns *load(std::istream &in);
+  void save(std::ostream &out) const;
+  double size_in_mega_bytes() const;
+
+ private:
+  sdsl::int_vector<> m_cuts;
+  sdsl::int_vector<> m_removed;
+};
+
+}
+#endif
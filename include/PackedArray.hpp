@@ -0,0 +1,176 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+#ifndef _PACKED_ARRAY_H
+#define _PACKED_ARRAY_H
+
+#include "MappedFile.hpp"
+
+#include <libcds/libcdsBasics.h>
+
+#include <cstring>
+#include <iostream>
+
+namespace cdat {
+
+/*
+ * Fixed width integers packed into 64-bit words, lowest bits first. A field
+ * is read with one unaligned 8-byte load, one spare word at the end keeps the
+ * load inside the array.
+ */
+class PackedArray {
+ public:
+  typedef uint64_t size_type;
+  typedef uint64_t value_type;
+
+  PackedArray() : m_data(nullptr), m_length(0), m_width(0), m_mask(0), m_owned(false) {};
+
+  PackedArray(size_type const length, size_type const width) :
+      m_data(new uint64_t[words_number(length, width)]()), m_length(length),
+      m_width(width), m_mask(mask(width)), m_owned(true) {};
+
+  PackedArray(PackedArray &&other) : PackedArray() {
+      *this = std::move(other);
+  }
+
+  PackedArray &operator=(PackedArray &&other) {
+      std::swap(m_data, other.m_data);
+      std::swap(m_length, other.m_length);
+      std::swap(m_width, other.m_width);
+      std::swap(m_mask, other.m_mask);
+      std::swap(m_owned, other.m_owned);
+      return *this;
+  }
+
+  ~PackedArray() {
+      if (m_owned)
+          delete[] m_data;
+  }
+
+  value_type get(size_type const idx) const {
+      size_type bit = idx * m_width;
+      if (m_width <= 56)
+          return (load_bytes(bit >> 3) >> (bit & 7)) & m_mask;
+
+      size_type word = bit >> 6, offset = bit & 63;
+      value_type result = m_data[word] >> offset;
+      if (offset + m_width > 64)
+          result |= m_data[word + 1] << (64 - offset);
+      return result & m_mask;
+  }
+
+  void set(size_type const idx, value_type const value) {
+      size_type bit = idx * m_width;
+      size_type word = bit >> 6, offset = bit & 63;
+      m_data[word] = (m_data[word] & ~(m_mask << offset)) | ((value & m_mask) << offset);
+      if (offset + m_width > 64) {
+          m_data[word + 1] = (m_data[word + 1] & ~(m_mask >> (64 - offset))) |
+              ((value & m_mask) >> (64 - offset));
+      }
+  }
+
+  // fields [begin, end) in one pass, the bit position moves without multiplication
+  void decode_range(size_type const begin, size_type const end, value_type *out) const {
+      if (m_width > 56) {
+          for (size_type i = begin; i < end; ++i)
+              *out++ = get(i);
+          return;
+      }
+
+      size_type bit = begin * m_width;
+      for (size_type i = begin; i < end; ++i, bit += m_width)
+          *out++ = (load_bytes(bit >> 3) >> (bit & 7)) & m_mask;
+  }
+
+  // asks for the word of field idx ahead of a later get
+  void prefetch(size_type const idx) const {
+      __builtin_prefetch((char const *) m_data + ((idx * m_width) >> 3));
+  }
+
+  size_type size() const {
+      return m_length;
+  }
+
+  size_type size_in_bytes() const {
+      return words_number(m_length, m_width) * sizeof(uint64_t);
+  }
+
+  // words start at a multiple of 8 bytes of the file, so a mapped file can be used in place
+  void save(std::ostream &file) const {
+      static char const padding[8] = {0};
+      file.write(padding, (8 - ((size_type) file.tellp() & 7)) & 7);
+      file.write((char *) m_data, size_in_bytes());
+  }
+
+  // index files of version 1 kept fields in 32-bit words, read into 64-bit words here
+  static PackedArray load(std::istream &file, size_type const length,
+                          size_type const width, uint const version) {
+      file.seekg((8 - ((size_type) file.tellg() & 7)) & 7, std::ios::cur);
+
+      PackedArray result;
+      result.m_length = length;
+      result.m_width = width;
+      result.m_mask = mask(width);
+
+      MappedBuffer *buffer = dynamic_cast<MappedBuffer *>(file.rdbuf());
+      if (buffer != nullptr && version > 1) {
+          result.m_data = (uint64_t *) buffer->position();
+          buffer->skip(result.size_in_bytes());
+          return result;
+      }
+
+      result.m_data = new uint64_t[words_number(length, width)]();
+      result.m_owned = true;
+      if (version > 1)
+          file.read((char *) result.m_data, result.size_in_bytes());
+      else {
+          file.read((char *) result.m_data, cds_utils::uint_len(width, length) * sizeof(uint));
+          // version 1 left whatever was in memory in the bits of its last word past the cells
+          size_type bits = length * width;
+          if ((bits & 63) != 0)
+              result.m_data[bits >> 6] &= mask(bits & 63);
+      }
+      return result;
+  }
+
+  static size_type words_number(size_type const length, size_type const width) {
+      return (length * width + 63) / 64 + 1;
+  }
+
+ private:
+  PackedArray(PackedArray const &) = delete;
+  PackedArray &operator=(PackedArray const &) = delete;
+
+  static value_type mask(size_type const width) {
+      return width >= 64 ? ~((value_type) 0) : (((value_type) 1) << width) - 1;
+  }
+
+  uint64_t load_bytes(size_type const byte) const {
+      uint64_t result;
+      std::memcpy(&result, (char const *) m_data + byte, sizeof(uint64_t));
+      return result;
+  }
+
+  uint64_t *m_data;
+  size_type m_length;
+  size_type m_width;
+  value_type m_mask;
+  // false when words point into a mapped index file
+  bool m_owned;
+};
+
+}
+#endif //_PACKED_ARRAY_H
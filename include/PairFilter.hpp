@@ -0,0 +1,96 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+#ifndef _PAIRFILTER_H
+#define _PAIRFILTER_H
+
+#include "Alphabet.hpp"
+#include "PackedArray.hpp"
+
+#include <fstream>
+
+namespace cdat {
+
+/*
+ * Blocked Bloom filter of the pairs of consecutive indexed words, words at
+ * positions i * shift and (i + 1) * shift. A pair sets HASHES bits of one block
+ * of BLOCK_BITS bits, so a lookup reads a single cache line. Filter never
+ * misses a pair of the text, absent pairs are reported present with small
+ * probability.
+ */
+class PairFilter {
+ public:
+  typedef uint64_t size_type;
+  typedef uint64_t value_type;
+
+  static size_type const BLOCK_BITS = 512;
+  static size_type const HASHES = 6;
+
+  PairFilter() : m_blocks_number(0) {};
+
+  // bits_per_pair bits of filter for each of the words_number - 1 pairs of the text,
+  // -1 when the filter has more than 2^32 blocks
+  int build(std::ifstream &file, size_type const word_size, size_type const shift,
+            Alphabet const *alphabet, size_type const words_number, size_type const bits_per_pair);
+
+  bool contains(value_type const first, value_type const second) const {
+      value_type hash = pair_hash(first, second);
+      size_type block = block_of(hash);
+      value_type bits = mix(hash);
+      for (size_type i = 0; i < HASHES; ++i, bits >>= 9) {
+          size_type bit = bits & (BLOCK_BITS - 1);
+          if (((m_bits.get(block + (bit >> 6)) >> (bit & 63)) & 1) == 0)
+              return false;
+      }
+
+      return true;
+  }
+
+  // block read by contains of the pair
+  void prefetch(value_type const first, value_type const second) const {
+      m_bits.prefetch(block_of(pair_hash(first, second)));
+  }
+
+  static PairFilter *load(std::istream &in, uint const version);
+  void save(std::ostream &out) const;
+  double size_in_mega_bytes() const;
+
+ private:
+  void add(value_type const first, value_type const second);
+
+  static value_type mix(value_type value) {
+      value ^= value >> 33;
+      value *= 0xff51afd7ed558ccdULL;
+      value ^= value >> 33;
+      value *= 0xc4ceb9fe1a85ec53ULL;
+      return value ^ (value >> 33);
+  }
+
+  static value_type pair_hash(value_type const first, value_type const second) {
+      return mix(first * 0x9e3779b97f4a7c15ULL + second);
+  }
+
+  // first word of the block picked by the high half of hash
+  size_type block_of(value_type const hash) const {
+      return (((hash >> 32) * m_blocks_number) >> 32) * (BLOCK_BITS / 64);
+  }
+
+  size_type m_blocks_number;
+  PackedArray m_bits;
+};
+
+}
+#endif
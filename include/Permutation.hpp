@@ -18,8 +18,13 @@
 #ifndef _PERMUTATION_H
 #define _PERMUTATION_H
 
+#include "PackedArray.hpp"
+
 #include <libcds/libcdsBasics.h>
 
+#include <iostream>
+#include <vector>
+
 namespace cdat {
 
 class Permutation {
@@ -27,34 +32,42 @@ class Permutation {
   typedef uint64_t size_type;
   typedef uint64_t value_type;
  protected:
-  uint *permutation;
+  PackedArray permutation;
   size_type length;
   size_type cell_size;
 
- public:
-
-  Permutation(size_type const size) : length(size) {
-      using namespace cds_utils;
+  Permutation(PackedArray &&permutation, size_type length, size_type cell_size) :
+      permutation(std::move(permutation)), length(length), cell_size(cell_size) {};
 
-      cell_size = bits(size - 1);
-      auto count = uint_len(cell_size, length);
+ public:
 
-      permutation = new uint[count];
-  };
+  Permutation(size_type const size) :
+      Permutation(size, cds_utils::bits(size - 1)) {};
 
-  Permutation(uint *permutation, size_type length, size_type cell_size) :
-      permutation(permutation), length(length), cell_size(cell_size) {};
+  Permutation(size_type const length, size_type const cell_size) :
+      permutation(length, cell_size), length(length), cell_size(cell_size) {};
 
-  virtual ~Permutation() { delete[] permutation; }
+  virtual ~Permutation() {}
 
   virtual void set_field(size_type const idx, value_type const value) {
-      cds_utils::set_field(permutation, cell_size, idx, value);
+      permutation.set(idx, value);
   };
 
-  value_type pi(size_type const idx) const {
-      return cds_utils::get_field(permutation, cell_size, idx);
+  virtual value_type pi(size_type const idx) const {
+      return permutation.get(idx);
   };
 
+  // values of pi for [begin, end), used to scan whole buckets at once
+  virtual void decode_range(size_type const begin, size_type const end,
+                            std::vector<value_type> *out) const {
+      out->resize(end - begin);
+      permutation.decode_range(begin, end, out->data());
+  }
+
+  virtual void prefetch(size_type const idx) const {
+      permutation.prefetch(idx);
+  }
+
   virtual value_type revpi(size_type const value) const {
       for (unsigned long long i = 0; i < length; ++i) {
           if (pi(i) == value)
@@ -65,32 +78,30 @@ class Permutation {
   }
 
   virtual double size_in_mega_bytes() const {
-      return ((sizeof(uint) * (cds_utils::uint_len(cell_size, length) + 2)) /
-          1024.0) / 1024.0;
+      return ((permutation.size_in_bytes() + 2 * sizeof(size_type)) / 1024.0) / 1024.0;
   }
 
-  size_type get_size() {
+  size_type get_size() const {
       return length;
   }
 
+  size_type get_cell_size() const {
+      return cell_size;
+  }
+
   virtual void save(std::ostream &file) const {
       file.write((char *) &length, sizeof(size_type));
       file.write((char *) &cell_size, sizeof(size_type));
-      file.write((char *) permutation,
-                 cds_utils::uint_len(cell_size, length) * sizeof(uint));
+      permutation.save(file);
   }
 
-  static Permutation *load(std::istream &file) {
+  static Permutation *load(std::istream &file, uint const version) {
       size_type length, cell_size;
 
       file.read((char *) &length, sizeof(size_type));
       file.read((char *) &cell_size, sizeof(size_type));
 
-      auto count = cds_utils::uint_len(cell_size, length);
-      uint *permutation = new uint[count];
-      file.read((char *) permutation, count * sizeof(uint));
-
-      return new Permutation(permutation, length, cell_size);
+      return new Permutation(PackedArray::load(file, length, cell_size, version), length, cell_size);
   }
 };
 
@@ -0,0 +1,68 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#ifndef _QGRAMTABLE_H
+#define _QGRAMTABLE_H
+
+#include "Alphabet.hpp"
+
+#include <vector>
+
+#include <sdsl/bit_vectors.hpp>
+
+namespace cdat {
+
+/*
+ * Number of occurrences of every word of length 1..max_length in the text.
+ * Counts for each length are kept like the main index directory: bit vector
+ * with one separator (1) per word and one 0 per occurrence.
+ */
+class QGramTable {
+ public:
+  typedef uint64_t size_type;
+  typedef uint64_t value_type;
+
+  QGramTable() : m_max_length(0) {};
+  ~QGramTable();
+
+  // words spanning one of the sorted boundaries of the text are not counted
+  int build(std::ifstream &file, size_type const max_length, Alphabet const *alphabet,
+            std::vector<size_type> const &boundaries);
+
+  size_type count(value_type const word_value, size_type const length) const;
+  size_type get_max_length() const {
+      return m_max_length;
+  }
+
+  static QGramTable *load(std::istream &in);
+  void save(std::ostream &out) const;
+  double size_in_mega_bytes() const;
+
+ private:
+  size_type m_max_length;
+  std::vector<sdsl::bit_vector *> m_bit_vectors;
+  std::vector<sdsl::bit_vector::select_1_type *> m_select1;
+};
+
+inline QGramTable::size_type QGramTable::count(value_type const word_value,
+                                               size_type const length) const {
+    auto select1 = m_select1[length - 1];
+    return select1->select(word_value + 2) - select1->select(word_value + 1) - 1;
+}
+
+}
+#endif
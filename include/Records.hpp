@@ -0,0 +1,76 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#ifndef _RECORDS_H
+#define _RECORDS_H
+
+#include "BucketDirectory.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace cdat {
+
+/*
+ * Record (contig) boundaries of a multi-sequence text, see replace_dna -f.
+ * Starts are kept in a sparse bit vector, so the record of a position is a
+ * single rank and its start a single select.
+ */
+class Records {
+ public:
+  typedef uint64_t size_type;
+
+  Records() : m_starts(nullptr) {};
+  ~Records();
+
+  // reads lines "position name" of the original text, sorted by position,
+  // the first record starts at 0
+  int build(char const *filename);
+
+  size_type size() const {
+      return m_names.size();
+  }
+
+  size_type find_record(size_type const position) const {
+      return m_starts->rank1(std::min(position + 1, m_starts->size())) - 1;
+  }
+
+  size_type get_start(size_type const record) const {
+      return m_starts->select1(record + 1);
+  }
+
+  std::string const &get_name(size_type const record) const {
+      return m_names[record];
+  }
+
+  // true when occurrence [position, position + length) spans a record boundary
+  bool crosses(size_type const position, size_type const length) const {
+      return length > 1 && find_record(position) != find_record(position + length - 1);
+  }
+
+  static Records *load(std::istream &in);
+  void save(std::ostream &out) const;
+  double size_in_mega_bytes() const;
+
+ private:
+  BucketDirectory *m_starts;
+  std::vector<std::string> m_names;
+};
+
+}
+#endif
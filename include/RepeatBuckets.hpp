@@ -0,0 +1,68 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#ifndef _REPEATBUCKETS_H
+#define _REPEATBUCKETS_H
+
+#include "Alphabet.hpp"
+#include "BucketDirectory.hpp"
+#include "Permutation.hpp"
+
+#include <vector>
+
+#include <sdsl/bit_vectors.hpp>
+
+namespace cdat {
+
+/*
+ * Buckets of the index holding more than threshold positions, for example
+ * words of satellite repeats. Positions of every such bucket are kept once
+ * more, ordered by the word that follows them in the text, so a query knowing
+ * the next characters reads only a range of the bucket.
+ */
+class RepeatBuckets {
+ public:
+  typedef uint64_t size_type;
+  typedef uint64_t value_type;
+
+  RepeatBuckets() : m_threshold(0) {};
+
+  int build(std::ifstream &file, BucketDirectory const *directory, Permutation const *permutation,
+            Alphabet const *alphabet, size_type const word_size, size_type const shift,
+            size_type const threshold);
+
+  // index of the capped bucket of word_value, false when the bucket is not capped
+  bool find(value_type const word_value, size_type *bucket) const;
+
+  // positions of bucket followed by a word from [lower, upper)
+  void decode_range(size_type const bucket, value_type const lower, value_type const upper,
+                    std::vector<value_type> *positions) const;
+
+  static RepeatBuckets *load(std::istream &in);
+  void save(std::ostream &out) const;
+  double size_in_mega_bytes() const;
+
+ private:
+  size_type m_threshold;
+  std::vector<value_type> m_words;
+  std::vector<size_type> m_offsets;
+  sdsl::int_vector<> m_next_words;
+  sdsl::int_vector<> m_positions;
+};
+
+}
+#endif
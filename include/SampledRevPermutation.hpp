@@ -0,0 +1,170 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#ifndef _SAMPLED_REV_PERMUTATION_H
+#define _SAMPLED_REV_PERMUTATION_H
+
+#include "Permutation.hpp"
+
+#include <sdsl/bit_vectors.hpp>
+
+namespace cdat {
+
+/*
+ * Permutation with inverse given by shortcut pointers: on every cycle longer
+ * than sampling, each sampling-th element stores the element sampling steps
+ * back, so revpi follows at most about 2 * sampling values of pi.
+ */
+class SampledRevPermutation : public Permutation {
+ private:
+  size_type m_sampling;
+  sdsl::bit_vector m_sampled;
+  sdsl::bit_vector::rank_1_type m_sampled_rank1;
+  PackedArray m_back_pointers;
+  size_type m_back_pointers_number;
+
+  SampledRevPermutation(PackedArray &&permutation, size_type length, size_type cell_size,
+                        size_type sampling) :
+      Permutation(std::move(permutation), length, cell_size), m_sampling(sampling),
+      m_back_pointers_number(0) {};
+
+  value_type back_pointer(size_type const idx) const {
+      return m_back_pointers.get(m_sampled_rank1.rank(idx));
+  }
+
+  void sample_inverse() {
+      m_sampled = sdsl::bit_vector(length, 0);
+      sdsl::bit_vector visited(length, 0);
+      std::vector<std::pair<size_type, size_type> > cycles;
+
+      for (size_type start = 0; start < length; ++start) {
+          if (visited[start])
+              continue;
+
+          size_type cycle_length = 0;
+          size_type idx = start;
+          do {
+              visited[idx] = 1;
+              idx = pi(idx);
+              ++cycle_length;
+          }
+          while (idx != start);
+
+          if (cycle_length <= m_sampling)
+              continue;
+
+          cycles.push_back(std::make_pair(start, cycle_length));
+          idx = start;
+          for (size_type i = 0; i < cycle_length; ++i) {
+              if (i % m_sampling == 0) {
+                  m_sampled[idx] = 1;
+                  ++m_back_pointers_number;
+              }
+              idx = pi(idx);
+          }
+      }
+
+      m_sampled_rank1 = sdsl::bit_vector::rank_1_type(&m_sampled);
+      m_back_pointers = PackedArray(m_back_pointers_number, cell_size);
+
+      for (size_type i = 0; i < cycles.size(); ++i) {
+          size_type idx = cycles[i].first;
+          size_type previous = idx;
+
+          for (size_type j = 0; j < cycles[i].second; ++j) {
+              if (j % m_sampling == 0 && j > 0) {
+                  m_back_pointers.set(m_sampled_rank1.rank(idx), previous);
+                  previous = idx;
+              }
+              idx = pi(idx);
+          }
+
+          m_back_pointers.set(m_sampled_rank1.rank(idx), previous);
+      }
+  }
+
+ public:
+
+  SampledRevPermutation(Permutation const *permutation, size_type const sampling) :
+      Permutation(permutation->get_size()), m_sampling(sampling),
+      m_back_pointers_number(0) {
+      for (size_type i = 0; i < length; ++i) {
+          Permutation::set_field(i, permutation->pi(i));
+      }
+
+      sample_inverse();
+  }
+
+  value_type revpi(size_type const value) const {
+      size_type idx = value;
+      bool jumped = false;
+
+      while (true) {
+          size_type next = Permutation::pi(idx);
+          if (next == value)
+              return idx;
+
+          if (!jumped && m_sampled[idx]) {
+              idx = back_pointer(idx);
+              jumped = true;
+          }
+          else {
+              idx = next;
+          }
+      }
+  }
+
+  double size_in_mega_bytes() const {
+      return Permutation::size_in_mega_bytes() + sdsl::size_in_mega_bytes(m_sampled) +
+          sdsl::size_in_mega_bytes(m_sampled_rank1) +
+          ((m_back_pointers.size_in_bytes() / 1024.0) / 1024.0);
+  }
+
+  void save(std::ostream &file) const {
+      Permutation::save(file);
+      file.write((char *) &m_sampling, sizeof(size_type));
+      m_sampled.serialize(file);
+      m_sampled_rank1.serialize(file);
+      file.write((char *) &m_back_pointers_number, sizeof(size_type));
+      m_back_pointers.save(file);
+  }
+
+  static SampledRevPermutation *load(std::istream &file, uint const version) {
+      size_type length, cell_size, sampling;
+
+      file.read((char *) &length, sizeof(size_type));
+      file.read((char *) &cell_size, sizeof(size_type));
+
+      PackedArray permutation = PackedArray::load(file, length, cell_size, version);
+      file.read((char *) &sampling, sizeof(size_type));
+
+      SampledRevPermutation *result = new SampledRevPermutation(std::move(permutation), length,
+                                                                cell_size, sampling);
+      result->m_sampled.load(file);
+      result->m_sampled_rank1.load(file, &result->m_sampled);
+
+      file.read((char *) &result->m_back_pointers_number, sizeof(size_type));
+      result->m_back_pointers = PackedArray::load(file, result->m_back_pointers_number,
+                                                  cell_size, version);
+
+      return result;
+  }
+
+};
+
+}
+#endif //_SAMPLED_REV_PERMUTATION_H
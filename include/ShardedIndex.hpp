@@ -0,0 +1,81 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#ifndef _SHARDEDINDEX_H
+#define _SHARDEDINDEX_H
+
+#include "Index.hpp"
+
+#include <string>
+#include <vector>
+
+namespace cdat {
+
+/*
+ * Text split into shards indexed separately, see tools/split_text. Every shard
+ * owns a range of the text and stores the following overlap characters too, so
+ * patterns up to overlap + 1 characters crossing a border are found in the shard
+ * where they start. Single queries run on the shards one after another, batches
+ * of patterns run on every shard as a batch of that index, on the scheduler when
+ * there is one.
+ */
+class ShardedIndex {
+ public:
+  typedef uint64_t size_type;
+
+  ShardedIndex() : m_overlap(0) {};
+  ~ShardedIndex();
+
+  // manifest has a line "overlap o" followed by lines "file offset length",
+  // files are mapped relative to the directory of the manifest
+  static ShardedIndex *load_manifest(char const *filename);
+
+  int count(std::string const &pattern, ulong const length, ulong *numocc) const;
+  int locate(std::string const &pattern, ulong const length, std::vector<ulong> *occ, ulong *numocc) const;
+  // same results as count and locate on every pattern, patterns longer than overlap + 1
+  // characters have no occurrences
+  void count_batch(std::vector<std::string> const &patterns, TaskScheduler *scheduler,
+                   std::vector<ulong> *numocc) const;
+  void locate_batch(std::vector<std::string> const &patterns, TaskScheduler *scheduler,
+                    std::vector<std::vector<ulong> > *occ, std::vector<ulong> *numocc) const;
+
+  double get_size_in_mega_bytes() const;
+
+  size_type get_shards_number() const {
+      return m_shards.size();
+  }
+
+ private:
+  struct Shard {
+    Index *index;
+    size_type offset;
+    size_type length;
+    // characters past the owned range, occurrences starting there belong to the next shard
+    std::string overlap;
+  };
+
+  bool validate(std::string const &pattern) const;
+  static std::string get_overlap(Index const *index, size_type const length);
+  static ulong count_overlap(std::string const &overlap, std::string const &pattern);
+  static ulong add_owned(Shard const &shard, std::vector<ulong> const &occ, std::vector<ulong> *result);
+
+  std::vector<Shard> m_shards;
+  size_type m_overlap;
+};
+
+}
+#endif
@@ -0,0 +1,63 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#ifndef _SUFFIXDIRECTORY_H
+#define _SUFFIXDIRECTORY_H
+
+#include "Alphabet.hpp"
+#include "BucketDirectory.hpp"
+#include "Permutation.hpp"
+
+#include <sdsl/bit_vectors.hpp>
+
+namespace cdat {
+
+/*
+ * Second bucket directory in which words are keyed by their value read
+ * right-to-left, so all words sharing a suffix occupy one contiguous range.
+ */
+class SuffixDirectory {
+ public:
+  typedef uint64_t size_type;
+  typedef uint64_t value_type;
+
+  SuffixDirectory() : m_bit_vector(nullptr), m_select1(nullptr), m_permutation(nullptr) {};
+  ~SuffixDirectory();
+
+  void build(BucketDirectory const *directory, Permutation const *permutation,
+             Alphabet const *alphabet, size_type const word_size);
+
+  size_type get_position(value_type const reversed_value) const {
+      return m_select1->select(reversed_value + 1) - reversed_value;
+  }
+
+  value_type pi(size_type const idx) const {
+      return m_permutation->pi(idx);
+  }
+
+  static SuffixDirectory *load(std::istream &in, uint const version);
+  void save(std::ostream &out) const;
+  double size_in_mega_bytes() const;
+
+ private:
+  sdsl::bit_vector *m_bit_vector;
+  sdsl::bit_vector::select_1_type *m_select1;
+  Permutation *m_permutation;
+};
+
+}
+#endif
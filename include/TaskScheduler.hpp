@@ -0,0 +1,81 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+#ifndef _TASKSCHEDULER_H
+#define _TASKSCHEDULER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cdat {
+
+/*
+ * Work-stealing pool of worker threads. Every worker keeps its own deque of tasks:
+ * tasks spawned by a worker go to its back and it takes the newest one first, idle
+ * workers steal the oldest task of the others. Tasks may spawn further tasks, wait
+ * returns when all of them are done.
+ */
+class TaskScheduler {
+ public:
+  typedef uint64_t size_type;
+  typedef std::function<void()> Task;
+
+  // 0 uses one worker per hardware thread
+  explicit TaskScheduler(size_type workers);
+  ~TaskScheduler();
+
+  TaskScheduler(TaskScheduler const &) = delete;
+  TaskScheduler &operator=(TaskScheduler const &) = delete;
+
+  void spawn(Task task);
+  void wait();
+
+  size_type get_workers_number() const {
+      return m_queues.size();
+  }
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void work(size_type const worker);
+  bool pop(size_type const worker, Task *task);
+  bool steal(size_type const worker, Task *task);
+
+  std::vector<std::unique_ptr<Queue> > m_queues;
+  std::vector<std::thread> m_threads;
+
+  std::mutex m_mutex;
+  std::condition_variable m_wakeup;
+  std::condition_variable m_done;
+  // tasks in the deques and tasks not finished yet
+  std::atomic<long> m_queued;
+  std::atomic<long> m_pending;
+  std::atomic<size_type> m_next_queue;
+  bool m_stop;
+};
+
+}
+#endif
@@ -0,0 +1,118 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#ifndef _WAVELETTEXT_H
+#define _WAVELETTEXT_H
+
+#include <stdexcept>
+#include <string>
+
+#include <sdsl/wavelet_trees.hpp>
+
+namespace cdat {
+
+/*
+ * Text of IndexWaveletTree. The wavelet structure holding it is chosen at
+ * build time, trading memory for point access speed.
+ */
+class WaveletText {
+ public:
+  typedef uint64_t size_type;
+
+  static uint const HUFFMAN = 0;
+  static uint const MATRIX = 1;
+  static uint const INTERLEAVED = 2;
+  static uint const HYBRID = 3;
+
+  virtual ~WaveletText() {};
+
+  virtual unsigned char access(size_type const idx) const = 0;
+  virtual size_type size() const = 0;
+
+  virtual uint get_type() const = 0;
+  virtual double size_in_mega_bytes() const = 0;
+  virtual void save(std::ostream &out) const = 0;
+
+  static WaveletText *create(uint const type, char const *filename);
+  static WaveletText *load(std::istream &in);
+
+  static bool parse_type(std::string const &name, uint *type);
+  static std::string get_type_name(uint const type);
+};
+
+template<class t_wavelet_tree, uint t_type>
+class SdslWaveletText : public WaveletText {
+ private:
+  t_wavelet_tree m_wavelet_tree;
+
+ public:
+  SdslWaveletText() {};
+
+  SdslWaveletText(char const *filename) {
+      construct(m_wavelet_tree, filename, 1);
+  }
+
+  // concrete structure for kernels templated on the text type
+  t_wavelet_tree const &get_wavelet_tree() const {
+      return m_wavelet_tree;
+  }
+
+  unsigned char access(size_type const idx) const {
+      return m_wavelet_tree[idx];
+  }
+
+  size_type size() const {
+      return m_wavelet_tree.size();
+  }
+
+  uint get_type() const {
+      return t_type;
+  }
+
+  double size_in_mega_bytes() const {
+      return sdsl::size_in_mega_bytes(m_wavelet_tree);
+  }
+
+  void save(std::ostream &out) const {
+      uint type = t_type;
+      out.write((char *) &type, sizeof(uint));
+      m_wavelet_tree.serialize(out);
+  }
+
+  static SdslWaveletText *load(std::istream &in) {
+      SdslWaveletText *text = new SdslWaveletText();
+      text->m_wavelet_tree.load(in);
+
+      return text;
+  }
+};
+
+typedef SdslWaveletText<sdsl::wt_huff<sdsl::bit_vector, sdsl::rank_support_v<>,
+                                      sdsl::select_support_scan<>, sdsl::select_support_scan<> >,
+                        WaveletText::HUFFMAN> HuffmanWaveletText;
+typedef SdslWaveletText<sdsl::wm_int<>, WaveletText::MATRIX> MatrixWaveletText;
+typedef SdslWaveletText<sdsl::wt_huff<sdsl::bit_vector_il<>, sdsl::bit_vector_il<>::rank_1_type,
+                                      sdsl::bit_vector_il<>::select_1_type,
+                                      sdsl::bit_vector_il<>::select_0_type>,
+                        WaveletText::INTERLEAVED> InterleavedWaveletText;
+typedef SdslWaveletText<sdsl::wt_huff<sdsl::hyb_vector<>, sdsl::hyb_vector<>::rank_1_type,
+                                      sdsl::hyb_vector<>::select_1_type,
+                                      sdsl::hyb_vector<>::select_0_type>,
+                        WaveletText::HYBRID> HybridWaveletText;
+
+}
+#endif
@@ -20,7 +20,11 @@
 
 #include "Index.hpp"
 #include "IndexBitVector.hpp"
+#include "IndexDna.hpp"
+#include "IndexMinimizer.hpp"
 #include "IndexPerm.hpp"
+#include "IndexTwoLevel.hpp"
 #include "IndexWaveletTree.hpp"
+#include "ShardedIndex.hpp"
 
 #endif //CDAT_CDAT_H
@@ -19,6 +19,7 @@
 
 #include <vector>
 #include <algorithm>
+#include <limits>
 
 namespace cdat {
 
@@ -43,6 +44,20 @@ void Alphabet::count_ifpower2() {
         m_if_power2 = false;
 }
 
+// exact powers, powers not fitting in 64 bits are left 0
+void Alphabet::compute_powers() {
+    value_type power = 1;
+    for (size_type i = 0; i < MAX_POWER; ++i) {
+        m_powers[i] = power;
+        m_divisors[i] = Divisor(power);
+
+        if (power != 0 && m_size > 1 && power > std::numeric_limits<value_type>::max() / m_size)
+            power = 0;
+        else
+            power *= m_size;
+    }
+}
+
 int Alphabet::build(char const *filename) {
     std::ifstream file(filename);
     std::string line;
@@ -72,6 +87,23 @@ int Alphabet::build(char const *filename) {
 
     file.close();
     count_ifpower2();
+    compute_powers();
+
+    return 0;
+}
+
+int Alphabet::build_from_characters(std::string const &characters) {
+    this->m_size = characters.size();
+    std::fill(m_alphabet, m_alphabet + ASCII, m_size + 1);
+    this->m_reverse_alphabet = new uchar[this->m_size];
+
+    for (unsigned int i = 0; i < this->m_size; ++i) {
+        m_alphabet[static_cast<uchar>(characters[i])] = i;
+        m_reverse_alphabet[i] = static_cast<uchar>(characters[i]);
+    }
+
+    count_ifpower2();
+    compute_powers();
 
     return 0;
 }
@@ -118,6 +150,7 @@ int Alphabet::build_from_text(char const *filename) {
 
     file.close();
     count_ifpower2();
+    compute_powers();
 
     return 0;
 }
@@ -144,14 +177,26 @@ Alphabet::value_type Alphabet::get_word_value(std::string const &word, size_type
     return result;
 }
 
+Alphabet::value_type Alphabet::get_reversed_word_value(std::string const &word, size_type const start,
+                                                     size_type const end) const {
+    value_type result = 0;
+
+    for (size_type i = end; i > start; --i) {
+        result *= this->m_size;
+        result += get_char_value(word[i - 1]);
+    }
+
+    return result;
+}
+
 std::string Alphabet::get_word_from_value(size_type const value, size_type const word_size) const {
     std::string result = "";
     size_t word_value = value;
-    size_t multiplier = (size_t) pow(this->m_size, word_size - 1);
 
-    for (; multiplier > 0; multiplier /= this->m_size) {
-        result += m_reverse_alphabet[word_value / multiplier];
-        word_value -= (word_value / multiplier) * multiplier;
+    for (size_type i = word_size; i > 0; --i) {
+        value_type char_value = m_divisors[i - 1].divide(word_value);
+        result += m_reverse_alphabet[char_value];
+        word_value -= char_value * m_powers[i - 1];
     }
 
     return result;
@@ -193,6 +238,7 @@ Alphabet *Alphabet::load(std::istream &file) {
         alphabet->m_alphabet[(uint) character] = value;
         alphabet->m_reverse_alphabet[value] = character;
     }
+    alphabet->compute_powers();
 
     return alphabet;
 }
@@ -0,0 +1,73 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#include "BucketDirectory.hpp"
+
+namespace cdat {
+
+uint const BucketDirectory::PLAIN;
+uint const BucketDirectory::SPARSE;
+uint const BucketDirectory::RRR;
+
+BucketDirectory *BucketDirectory::create(uint const type, sdsl::bit_vector const &bit_vector,
+                                         bool const select0_support) {
+    if (type == SPARSE)
+        return new SparseBucketDirectory(bit_vector, select0_support);
+    if (type == RRR)
+        return new RRRBucketDirectory(bit_vector, select0_support);
+
+    return new PlainBucketDirectory(bit_vector, select0_support);
+}
+
+BucketDirectory *BucketDirectory::load(std::istream &in) {
+    uint type;
+    in.read((char *) &type, sizeof(uint));
+
+    if (type == PLAIN)
+        return PlainBucketDirectory::load(in);
+    if (type == SPARSE)
+        return SparseBucketDirectory::load(in);
+    if (type == RRR)
+        return RRRBucketDirectory::load(in);
+
+    std::cerr << "Wrong directory type!\n";
+    throw std::runtime_error("Wrong directory type");
+}
+
+bool BucketDirectory::parse_type(std::string const &name, uint *type) {
+    if (name == "plain")
+        *type = PLAIN;
+    else if (name == "sd")
+        *type = SPARSE;
+    else if (name == "rrr")
+        *type = RRR;
+    else
+        return false;
+
+    return true;
+}
+
+std::string BucketDirectory::get_type_name(uint const type) {
+    if (type == SPARSE)
+        return "sd";
+    if (type == RRR)
+        return "rrr";
+
+    return "plain";
+}
+
+}
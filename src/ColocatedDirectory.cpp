@@ -0,0 +1,79 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#include "ColocatedDirectory.hpp"
+
+namespace cdat {
+
+int ColocatedDirectory::build(BucketDirectory const *directory, Permutation const *permutation,
+                              size_type const words_number, size_type const leading) {
+    if (permutation->get_cell_size() > 32)
+        return -1;
+
+    // one spare block keeps the end of the last bucket, needed by bounds of ranges of words
+    size_type blocks_number = words_number / BLOCK_WORDS + 1;
+    m_leading = leading;
+    m_stride = 1 + BLOCK_WORDS + BLOCK_WORDS * leading;
+    m_blocks = PackedArray(blocks_number * m_stride, 32);
+
+    auto bucket_start = [&](value_type word_value) {
+        word_value = std::min(word_value, words_number);
+        return directory->select1(word_value + 1) - word_value;
+    };
+
+    for (size_type i = 0; i < blocks_number; ++i) {
+        size_type block = i * m_stride;
+        size_type start = bucket_start(i * BLOCK_WORDS);
+        m_blocks.set(block, start);
+
+        for (size_type j = 0; j < BLOCK_WORDS; ++j) {
+            size_type begin = bucket_start(i * BLOCK_WORDS + j);
+            size_type end = bucket_start(i * BLOCK_WORDS + j + 1);
+            m_blocks.set(block + 1 + j, end - start);
+
+            for (size_type k = 0; k < leading && begin + k < end; ++k) {
+                m_blocks.set(block + 1 + BLOCK_WORDS + j * leading + k, permutation->pi(begin + k));
+            }
+        }
+    }
+
+    return 0;
+}
+
+double ColocatedDirectory::size_in_mega_bytes() const {
+    return (m_blocks.size_in_bytes() / 1024.0) / 1024.0;
+}
+
+void ColocatedDirectory::save(std::ostream &out) const {
+    size_type length = m_blocks.size();
+    out.write((char *) &m_leading, sizeof(size_type));
+    out.write((char *) &length, sizeof(size_type));
+    m_blocks.save(out);
+}
+
+ColocatedDirectory *ColocatedDirectory::load(std::istream &in, uint const version) {
+    ColocatedDirectory *directory = new ColocatedDirectory();
+    size_type length;
+    in.read((char *) &directory->m_leading, sizeof(size_type));
+    in.read((char *) &length, sizeof(size_type));
+    directory->m_stride = 1 + BLOCK_WORDS + BLOCK_WORDS * directory->m_leading;
+    directory->m_blocks = PackedArray::load(in, length, 32, version);
+
+    return directory;
+}
+
+}
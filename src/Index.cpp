@@ -17,51 +17,89 @@
 
 #include "Index.hpp"
 #include "IndexBitVector.hpp"
+#include "IndexDna.hpp"
+#include "IndexMinimizer.hpp"
 #include "IndexPerm.hpp"
+#include "IndexTwoLevel.hpp"
 #include "IndexWaveletTree.hpp"
 
 namespace cdat {
 
+uint const Index::FILE_MAGIC = 0x74616463;
+uint const Index::FILE_VERSION = 2;
+
 Index::Index(size_type word_size, size_type shift, size_type text_length,
-             size_type additional_text_length, sdsl::bit_vector *bit_vector,
-             sdsl::bit_vector::rank_1_type *m_rank1,
-             sdsl::bit_vector::select_1_type *m_select1,
+             size_type additional_text_length, BucketDirectory *directory,
              Permutation *permutation, Alphabet *alphabet) :
     m_word_size(word_size),
     m_shift(shift), m_text_length(text_length),
-    m_additional_text_length(additional_text_length), m_bit_vector(bit_vector),
-    m_rank1(m_rank1), m_select1(m_select1),
-    m_permutation(permutation), m_alphabet(alphabet)
+    m_additional_text_length(additional_text_length), m_directory(directory),
+    m_permutation(permutation), m_alphabet(alphabet),
+    m_qgram_table(nullptr), m_build_qgram_table(false),
+    m_suffix_directory(nullptr), m_build_suffix_directory(false),
+    m_directory_type(directory->get_type()),
+    m_repeat_buckets(nullptr), m_repeat_threshold(0), m_masked_runs(nullptr),
+    m_records(nullptr), m_shared_boundaries(false), m_colocated_directory(nullptr), m_colocated_leading(0),
+    m_pair_filter(nullptr), m_pair_filter_bits(0), m_mapped_file(nullptr), m_deferred_sections(false), m_file_version(FILE_VERSION)
 {}
 
 Index::~Index() {
     delete m_permutation;
-    delete m_bit_vector;
-    delete m_select1;
-    delete m_rank1;
+    delete m_directory;
     delete m_alphabet;
+    delete m_qgram_table;
+    delete m_suffix_directory;
+    delete m_repeat_buckets;
+    if (!m_shared_boundaries) {
+        delete m_masked_runs;
+        delete m_records;
+    }
+    delete m_colocated_directory;
+    delete m_pair_filter;
+    delete m_mapped_file;
 }
 
-void Index::create_bit_vector_support() {
-    m_select1 = new sdsl::bit_vector::select_1_type(m_bit_vector);
-    m_rank1 = new sdsl::bit_vector::rank_1_type(m_bit_vector);
+void Index::create_bit_vector_support(sdsl::bit_vector const &bit_vector) {
+    m_directory = BucketDirectory::create(m_directory_type, bit_vector, false);
 }
 
 double Index::get_size_in_mega_bytes() const {
-    double result = sdsl::size_in_mega_bytes(*m_bit_vector);
-    result += sdsl::size_in_mega_bytes(*m_rank1);
-    result += sdsl::size_in_mega_bytes(*m_select1);
-    result += m_permutation->size_in_mega_bytes();
+    double result = m_directory->size_in_mega_bytes();
+    if (m_permutation != nullptr)
+        result += m_permutation->size_in_mega_bytes();
+    if (m_qgram_table != nullptr)
+        result += m_qgram_table->size_in_mega_bytes();
+    if (m_suffix_directory != nullptr)
+        result += m_suffix_directory->size_in_mega_bytes();
+    if (m_repeat_buckets != nullptr)
+        result += m_repeat_buckets->size_in_mega_bytes();
+    if (m_masked_runs != nullptr && !m_shared_boundaries)
+        result += m_masked_runs->size_in_mega_bytes();
+    if (m_records != nullptr && !m_shared_boundaries)
+        result += m_records->size_in_mega_bytes();
+    if (m_colocated_directory != nullptr)
+        result += m_colocated_directory->size_in_mega_bytes();
+    if (m_pair_filter != nullptr)
+        result += m_pair_filter->size_in_mega_bytes();
 
     return result;
 }
 
 Index::size_type Index::rank_0(const Index::size_type idx) const {
-    return idx - m_rank1->rank(idx);
+    return idx - m_directory->rank1(idx);
+}
+
+int Index::create_alphabet(char const *filename) {
+    m_alphabet = new Alphabet();
+    return m_alphabet->build_from_text(filename);
 }
 
-Permutation *Index::create_permutation(size_type const size) const {
-    return new Permutation(size);
+Permutation *Index::create_permutation(size_type const size, size_type const sampled_words) const {
+    return new Permutation(size, cds_utils::bits(sampled_words - 1));
+}
+
+Permutation *Index::load_permutation(std::istream &in) const {
+    return Permutation::load(in, m_file_version);
 }
 
 #ifdef DEBUG
@@ -87,15 +125,212 @@ void Index::print_time(timeval &start, char const *const msg) {
 }
 #endif
 
+Index::size_type Index::sampled_position(value_type const idx) const {
+    return idx * m_shift;
+}
+
 Index::size_type Index::get_position_in_permutation(value_type const word_value) const {
-    size_type position = m_select1->select(word_value + 1);
+    if (m_colocated_directory != nullptr) {
+        size_type begin, end;
+        m_colocated_directory->get_bucket(word_value, &begin, &end);
+        return begin;
+    }
+
+    size_type position = m_directory->select1(word_value + 1);
     return (position - word_value);
 }
 
+void Index::get_bucket(value_type const word_value, size_type *begin, size_type *end) const {
+    if (m_colocated_directory != nullptr) {
+        m_colocated_directory->get_bucket(word_value, begin, end);
+        return;
+    }
+
+    *begin = m_directory->select1(word_value + 1) - word_value;
+    *end = m_directory->select1(word_value + 2) - word_value - 1;
+}
+
+void Index::decode_positions(value_type const word_value, size_type const begin, size_type const end,
+                             std::vector<value_type> *positions) const {
+    if (m_colocated_directory == nullptr) {
+        load_sections();
+        m_permutation->decode_range(begin, end, positions);
+        return;
+    }
+
+    // small buckets are read whole from the colocated directory, without the permutation
+    size_type leading = std::min(end - begin, m_colocated_directory->get_leading_number());
+    positions->resize(leading);
+    m_colocated_directory->get_leading(word_value, leading, positions->data());
+    if (begin + leading < end) {
+        std::vector<value_type> rest;
+        load_sections();
+        m_permutation->decode_range(begin + leading, end, &rest);
+        positions->insert(positions->end(), rest.begin(), rest.end());
+    }
+}
+
+void Index::decode_bucket(size_type const begin, size_type const end, value_type const word_value,
+                          std::string const &pattern, size_type const next_start,
+                          std::vector<value_type> *positions) const {
+    size_type bucket;
+    if (m_repeat_buckets == nullptr || next_start >= pattern.length() ||
+        !m_repeat_buckets->find(word_value, &bucket)) {
+        decode_positions(word_value, begin, end, positions);
+        return;
+    }
+
+    // capped bucket, read only positions followed by the next characters of the pattern
+    size_type next_length = std::min(m_word_size, pattern.length() - next_start);
+    value_type padding = m_alphabet->pow_wsize(m_word_size - next_length);
+    value_type lower = m_alphabet->get_word_value(pattern, next_start, next_start + next_length) * padding;
+
+    m_repeat_buckets->decode_range(bucket, lower, lower + padding, positions);
+}
+
+void Index::decode_scan(value_type const word_value, std::string const &pattern, size_type const start,
+                        Slice const *slice, std::vector<value_type> *positions) const {
+    if (slice != nullptr && slice->start != start) {
+        positions->clear();
+        return;
+    }
+
+    size_type begin, end;
+    get_bucket(word_value, &begin, &end);
+    if (slice == nullptr || (slice->begin == begin && slice->end == end)) {
+        decode_bucket(begin, end, word_value, pattern, start + m_word_size, positions);
+        return;
+    }
+
+    // split buckets are never capped, leading positions all fall into the first slice
+    if (slice->begin == begin) {
+        decode_positions(word_value, begin, slice->end, positions);
+        return;
+    }
+
+    load_sections();
+    m_permutation->decode_range(slice->begin, slice->end, positions);
+}
+
+/*
+ * Occurrence starting at a text position p holds the indexed words at pattern
+ * offsets o, o + shift, ... where o = -p mod shift, so every such alignment
+ * needs its consecutive pairs in the text. Pairs tested for an alignment touch
+ * each other and the last one ends the alignment, so a mismatch anywhere in the
+ * covered part is still caught. Alignments too short for a pair can't be told apart.
+ */
+bool Index::may_occur(std::string const &pattern) const {
+    if (m_pair_filter == nullptr || pattern.length() < m_word_size + 2 * m_shift - 1)
+        return true;
+
+    // the query reads the buckets of the first shift words anyway, while they hold few
+    // cells scanning them costs less than the cache misses of the filter
+    size_type cells = 0;
+    for (size_type start = 0; start < m_shift && cells <= FILTER_CELLS; ++start) {
+        size_type begin, end;
+        get_bucket(m_alphabet->get_word_value(pattern, start, start + m_word_size), &begin, &end);
+        cells += end - begin;
+    }
+    if (cells <= FILTER_CELLS)
+        return true;
+
+    // alignments are tested by their first pairs, prefetched PAIR_GROUP at a time, and most
+    // wrong alignments end there; the other pairs of an alignment follow in groups as well.
+    // Words go to fixed buffers, so no query allocates, and the second word of a pair is
+    // rolled from the first.
+    Divisor const &divisor = m_alphabet->get_divisor(m_word_size - m_shift);
+    value_type shift_power = m_alphabet->pow_wsize(m_shift);
+    value_type heads[2 * PAIR_GROUP], pairs[2 * PAIR_GROUP];
+    auto load_pair = [&](value_type *words, size_type const position) {
+        size_type end = position + m_word_size;
+        words[0] = m_alphabet->get_word_value(pattern, position, end);
+        words[1] = divisor.modulo(words[0]) * shift_power + m_alphabet->get_word_value(pattern, end, end + m_shift);
+        m_pair_filter->prefetch(words[0], words[1]);
+    };
+
+    size_type words_number = pattern.length() - m_word_size + 1;
+    size_type step = ((m_word_size + m_shift) / m_shift) * m_shift;
+    for (size_type from = 0; from < m_shift; from += PAIR_GROUP) {
+        size_type alignments = std::min((size_type) PAIR_GROUP, m_shift - from);
+        for (size_type i = 0; i < alignments; ++i)
+            load_pair(heads + 2 * i, from + i);
+
+        for (size_type i = 0; i < alignments; ++i) {
+            size_type offset = from + i;
+            size_type last = offset + ((words_number - 1 - m_shift - offset) / m_shift) * m_shift;
+            bool present = m_pair_filter->contains(heads[2 * i], heads[2 * i + 1]);
+            for (size_type position = offset; present && position < last; ) {
+                size_type loaded = 0;
+                for (; loaded < PAIR_GROUP && position < last; ++loaded) {
+                    position = std::min(position + step, last);
+                    load_pair(pairs + 2 * loaded, position);
+                }
+
+                for (size_type j = 0; present && j < loaded; ++j)
+                    present = m_pair_filter->contains(pairs[2 * j], pairs[2 * j + 1]);
+            }
+
+            if (present)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+bool Index::split_query(std::string const &pattern, size_type const max_cells,
+                        std::vector<Slice> *slices) const {
+    slices->clear();
+
+    if (!m_alphabet->validate_word(pattern) ||
+        pattern.length() < m_word_size + m_shift - 1)
+        return false;
+    if (!may_occur(pattern))
+        return true;
+
+    size_type leading = m_colocated_directory != nullptr ? m_colocated_directory->get_leading_number() : 0;
+    size_type cells = std::max(max_cells, leading);
+    size_type limit = std::min(m_shift, (size_type) pattern.length() - m_word_size + 1);
+    for (size_type start = 0; start < limit; ++start) {
+        value_type word_value = m_alphabet->get_word_value(pattern, start, start + m_word_size);
+        Slice slice;
+        slice.start = start;
+        get_bucket(word_value, &slice.begin, &slice.end);
+
+        // capped buckets are read by the following word of the pattern, they stay whole
+        size_type bucket;
+        size_type end = slice.end;
+        bool capped = m_repeat_buckets != nullptr && start + m_word_size < pattern.length() &&
+            m_repeat_buckets->find(word_value, &bucket);
+        for (; slice.begin < end; slice.begin = slice.end) {
+            slice.end = capped ? end : std::min(end, slice.begin + cells);
+            slices->push_back(slice);
+        }
+    }
+
+    return true;
+}
+
+int Index::count_slice(std::string const &pattern, Slice const &slice, ulong *numocc) const {
+    load_sections();
+    return count_full_words(pattern, pattern.length(), false, numocc, NULL, &slice);
+}
+
+int Index::locate_slice(std::string const &pattern, Slice const &slice, std::vector<ulong> *occ,
+                        ulong *numocc) const {
+    load_sections();
+    size_type first = occ->size();
+    int result = count_full_words(pattern, pattern.length(), true, numocc, occ, &slice);
+    if (m_masked_runs != nullptr && !m_shared_boundaries)
+        to_original(first, occ);
+
+    return result;
+}
+
 Index::value_type Index::perm_binary_search(size_type const word_value,
                                             size_type const genome_words_number) const {
-    auto sel1 = m_select1->select(word_value + 1);
-    auto sel2 = m_select1->select(word_value + 2);
+    auto sel1 = m_directory->select1(word_value + 1);
+    auto sel2 = m_directory->select1(word_value + 2);
     auto start = rank_0(sel1);
     auto end = rank_0(sel2) - 1;
 
@@ -120,7 +355,7 @@ void Index::create_permutation(std::ifstream &file, size_type const genome_words
     file.clear();
     file.seekg(0, std::ios::beg);
 
-    size_t divisor = m_alphabet->pow_wsize(m_word_size - m_shift);
+    Divisor const &divisor = m_alphabet->get_divisor(m_word_size - m_shift);
     bool additional_word = false;
     size_type position = 0;
     size_type word_value = 0;
@@ -146,7 +381,7 @@ void Index::create_permutation(std::ifstream &file, size_type const genome_words
             if (word_length == m_word_size) {
                 auto start = perm_binary_search(word_value, genome_words_number);
                 m_permutation->set_field(start, position++);
-                word_value %= divisor;
+                word_value = divisor.modulo(word_value);
                 word_length -= m_shift;
                 additional_word = false;
             }
@@ -175,11 +410,10 @@ int Index::count_index(std::string const &pattern, ulong const from, ulong *numo
         return 0;
     }
 
-    auto word_value = m_alphabet->get_word_value(pattern, from, from + m_word_size) + 1;
-    auto position = m_select1->select(word_value);
-    auto next_position = m_select1->select(word_value + 1);
+    size_type begin, end;
+    get_bucket(m_alphabet->get_word_value(pattern, from, from + m_word_size), &begin, &end);
 
-    *numocc = next_position - position - 1;
+    *numocc = end - begin;
 
     return 0;
 }
@@ -190,10 +424,21 @@ int Index::count(std::string const &pattern, ulong const length, ulong *numocc)
         return 0;
     }
 
+    if (m_qgram_table != nullptr && !pattern.empty() && pattern.length() < m_word_size) {
+        *numocc = m_qgram_table->count(m_alphabet->get_word_value(pattern), pattern.length());
+        return 0;
+    }
+
+    if (!may_occur(pattern)) {
+        *numocc = 0;
+        return 0;
+    }
+
+    load_sections();
     if (pattern.length() < m_word_size + m_shift - 1)
         return count_short(pattern, length, false, numocc, NULL);
     else
-        return count_full_words(pattern, length, false, numocc, NULL);
+        return count_full_words(pattern, length, false, numocc, NULL, NULL);
 }
 
 int Index::locate_index(std::string const &pattern, ulong const from, std::vector<ulong> *occ, ulong *numocc) const {
@@ -206,12 +451,14 @@ int Index::locate_index(std::string const &pattern, ulong const from, std::vecto
         return 0;
     }
 
-    auto word_value = m_alphabet->get_word_value(pattern, from, from + m_word_size) + 1;
-    auto position = m_select1->select(word_value) - word_value + 1;
-    auto next_position = m_select1->select(word_value + 1) - word_value;
+    auto word_value = m_alphabet->get_word_value(pattern, from, from + m_word_size);
+    size_type position, next_position;
+    get_bucket(word_value, &position, &next_position);
 
-    for (ulong i = position; i < next_position; ++i) {
-        occ->push_back(m_permutation->pi(i) * m_shift);
+    std::vector<value_type> positions;
+    decode_positions(word_value, position, next_position, &positions);
+    for (ulong i = 0; i < positions.size(); ++i) {
+        occ->push_back(sampled_position(positions[i]));
     }
 
     *numocc = next_position - position + 1;
@@ -219,6 +466,163 @@ int Index::locate_index(std::string const &pattern, ulong const from, std::vecto
     return 0;
 }
 
+/*
+ * Every query of a group goes through the same steps for each word the full word scan
+ * looks up: directory block, permutation cells of the bucket, text at the first position.
+ * A step only issues the prefetch for the next one, so while one lookup waits for memory
+ * the others go on, and the final count or locate finds its lookups in cache.
+ */
+template<typename t_run>
+void Index::run_interleaved(std::vector<std::string> const &patterns, size_type const from, size_type const to,
+                            t_run run) const {
+    struct Lookup {
+        value_type word_value;
+        size_type begin;
+        size_type end;
+    };
+    size_type leading = m_colocated_directory != nullptr ? m_colocated_directory->get_leading_number() : 0;
+    std::vector<Lookup> lookups;
+    lookups.reserve(QUERY_GROUP * m_shift);
+
+    for (size_type first = from; first < to; first += QUERY_GROUP) {
+        size_type last = std::min(first + QUERY_GROUP, to);
+
+        lookups.clear();
+        for (size_type i = first; i < last; ++i) {
+            std::string const &pattern = patterns[i];
+            if (pattern.length() < m_word_size || !m_alphabet->validate_word(pattern))
+                continue;
+
+            size_type limit = std::min(m_shift, (size_type) pattern.length() - m_word_size + 1);
+            for (size_type start = 0; start < limit; ++start) {
+                Lookup lookup;
+                lookup.word_value = m_alphabet->get_word_value(pattern, start, start + m_word_size);
+                if (m_colocated_directory != nullptr)
+                    m_colocated_directory->prefetch(lookup.word_value);
+                lookups.push_back(lookup);
+            }
+        }
+
+        for (Lookup &lookup : lookups) {
+            // leading positions of the bucket came with the directory block
+            get_bucket(lookup.word_value, &lookup.begin, &lookup.end);
+            if (lookup.begin + leading < lookup.end) {
+                load_sections();
+                m_permutation->prefetch(lookup.begin + leading);
+            }
+        }
+
+        for (Lookup const &lookup : lookups) {
+            if (lookup.begin == lookup.end)
+                continue;
+
+            value_type position;
+            if (leading > 0)
+                m_colocated_directory->get_leading(lookup.word_value, 1, &position);
+            else
+                position = m_permutation->pi(lookup.begin);
+            prefetch_text(sampled_position(position));
+        }
+
+        for (size_type i = first; i < last; ++i) {
+            run(i);
+        }
+    }
+}
+
+void Index::count_batch(std::vector<std::string> const &patterns, std::vector<ulong> *numocc) const {
+    numocc->assign(patterns.size(), 0);
+    run_interleaved(patterns, 0, patterns.size(), [&](size_type i) {
+        count(patterns[i], patterns[i].length(), &(*numocc)[i]);
+    });
+}
+
+void Index::locate_batch(std::vector<std::string> const &patterns, std::vector<std::vector<ulong> > *occ,
+                         std::vector<ulong> *numocc) const {
+    numocc->assign(patterns.size(), 0);
+    occ->assign(patterns.size(), std::vector<ulong>());
+    run_interleaved(patterns, 0, patterns.size(), [&](size_type i) {
+        locate(patterns[i], patterns[i].length(), &(*occ)[i], &(*numocc)[i]);
+    });
+}
+
+/*
+ * Every task takes a group of QUERY_GROUP patterns, interleaved like in count_batch, and
+ * answers those with a cheap scan at once, the others spawn a task per slice, so a repeat verified over a large bucket is shared by
+ * idle workers.
+ * Slice results are merged in scan order after all tasks are done.
+ */
+void Index::count_parallel(std::vector<std::string> const &patterns, TaskScheduler *scheduler,
+                           std::vector<ulong> *numocc) const {
+    numocc->assign(patterns.size(), 0);
+    std::vector<std::vector<ulong> > slice_counts(patterns.size());
+
+    for (size_type first = 0; first < patterns.size(); first += QUERY_GROUP) {
+        size_type last = std::min(first + QUERY_GROUP, (size_type) patterns.size());
+        scheduler->spawn([&, first, last]() {
+            std::vector<Slice> slices;
+            run_interleaved(patterns, first, last, [&](size_type i) {
+                if (!split_query(patterns[i], SLICE_CELLS, &slices) || get_cells(slices) <= SLICE_CELLS) {
+                    count(patterns[i], patterns[i].length(), &(*numocc)[i]);
+                    return;
+                }
+
+                slice_counts[i].assign(slices.size(), 0);
+                for (size_type j = 0; j < slices.size(); ++j) {
+                    Slice slice = slices[j];
+                    scheduler->spawn([&, i, j, slice]() {
+                        count_slice(patterns[i], slice, &slice_counts[i][j]);
+                    });
+                }
+            });
+        });
+    }
+    scheduler->wait();
+
+    for (size_type i = 0; i < patterns.size(); ++i) {
+        for (size_type j = 0; j < slice_counts[i].size(); ++j)
+            (*numocc)[i] += slice_counts[i][j];
+    }
+}
+
+void Index::locate_parallel(std::vector<std::string> const &patterns, TaskScheduler *scheduler,
+                            std::vector<std::vector<ulong> > *occ, std::vector<ulong> *numocc) const {
+    numocc->assign(patterns.size(), 0);
+    occ->assign(patterns.size(), std::vector<ulong>());
+    std::vector<std::vector<ulong> > slice_counts(patterns.size());
+    std::vector<std::vector<std::vector<ulong> > > slice_occ(patterns.size());
+
+    for (size_type first = 0; first < patterns.size(); first += QUERY_GROUP) {
+        size_type last = std::min(first + QUERY_GROUP, (size_type) patterns.size());
+        scheduler->spawn([&, first, last]() {
+            std::vector<Slice> slices;
+            run_interleaved(patterns, first, last, [&](size_type i) {
+                if (!split_query(patterns[i], SLICE_CELLS, &slices) || get_cells(slices) <= SLICE_CELLS) {
+                    locate(patterns[i], patterns[i].length(), &(*occ)[i], &(*numocc)[i]);
+                    return;
+                }
+
+                slice_counts[i].assign(slices.size(), 0);
+                slice_occ[i].assign(slices.size(), std::vector<ulong>());
+                for (size_type j = 0; j < slices.size(); ++j) {
+                    Slice slice = slices[j];
+                    scheduler->spawn([&, i, j, slice]() {
+                        locate_slice(patterns[i], slice, &slice_occ[i][j], &slice_counts[i][j]);
+                    });
+                }
+            });
+        });
+    }
+    scheduler->wait();
+
+    for (size_type i = 0; i < patterns.size(); ++i) {
+        for (size_type j = 0; j < slice_counts[i].size(); ++j) {
+            (*numocc)[i] += slice_counts[i][j];
+            (*occ)[i].insert((*occ)[i].end(), slice_occ[i][j].begin(), slice_occ[i][j].end());
+        }
+    }
+}
+
 int Index::locate(std::string const &pattern, ulong const length, std::vector<ulong> *occ,
                   ulong *numocc) const {
     if (!m_alphabet->validate_word(pattern)) {
@@ -226,21 +630,81 @@ int Index::locate(std::string const &pattern, ulong const length, std::vector<ul
         return 0;
     }
 
+    if (!may_occur(pattern)) {
+        *numocc = 0;
+        return 0;
+    }
+
+    load_sections();
+    size_type first = occ->size();
+    int result;
     if (pattern.length() < m_word_size + m_shift - 1) {
-        return count_short(pattern, length, true, numocc, occ);
+        result = count_short(pattern, length, true, numocc, occ);
     }
     else {
-        return count_full_words(pattern, length, true, numocc, occ);
+        result = count_full_words(pattern, length, true, numocc, occ, NULL);
     }
+
+    if (m_masked_runs != nullptr && !m_shared_boundaries)
+        to_original(first, occ);
+
+    return result;
+}
+
+void Index::to_original(size_type const first, std::vector<ulong> *occ) const {
+    for (size_type i = first; i < occ->size(); ++i)
+        (*occ)[i] = m_masked_runs->to_original((*occ)[i]);
+}
+
+int Index::extract(ulong const from, ulong const to, std::string *text, ulong *length) const {
+    load_sections();
+    if (m_masked_runs == nullptr)
+        return extract_text(from, to, text, length);
+
+    // walk the original text, reading masked runs as MASK_CHAR and the rest from the index
+    size_type original_length = m_text_length + m_masked_runs->removed_before(m_masked_runs->size());
+    ulong _to = std::min(to, original_length);
+    if (_to < from) {
+        *length = 0;
+        return -1;
+    }
+
+    *length = _to - from;
+    size_type position = from;
+    size_type run = m_masked_runs->find_run(position);
+    while (position < _to) {
+        if (run < m_masked_runs->size() && m_masked_runs->original_start(run) <= position) {
+            size_type run_end = std::min((size_type) _to, m_masked_runs->original_end(run));
+            text->append(run_end - position, MaskedRuns::MASK_CHAR);
+            position = run_end;
+            ++run;
+            continue;
+        }
+
+        size_type chunk_end = _to;
+        if (run < m_masked_runs->size())
+            chunk_end = std::min(chunk_end, m_masked_runs->original_start(run));
+
+        size_type removed = m_masked_runs->removed_before(run);
+        ulong chunk_length;
+        extract_text(position - removed, chunk_end - removed, text, &chunk_length);
+        position = chunk_end;
+    }
+
+    return 0;
 }
 
 void Index::verify_occurrences(size_type const start, size_type const end, size_type const length,
                                size_type const offset, ulong *numocc, std::vector<ulong> *occ) const {
-    for (ulong i = start; i < end; ++i) {
-        size_type word_position = m_permutation->pi(i) * m_shift;
+    std::vector<value_type> positions;
+    m_permutation->decode_range(start, end, &positions);
+
+    for (ulong i = 0; i < positions.size(); ++i) {
+        size_type word_position = positions[i] * m_shift;
 
-        if (word_position + offset + length <= m_text_length) {
-            occ->push_back(word_position + offset);
+        if (word_position + offset + length <= segment_end(word_position + offset)) {
+            if (occ != NULL)
+                occ->push_back(word_position + offset);
         }
         else {
             --(*numocc);
@@ -248,15 +712,73 @@ void Index::verify_occurrences(size_type const start, size_type const end, size_
     }
 }
 
+Index::size_type Index::boundary_end(size_type const position) const {
+    size_type end = m_text_length;
+    size_type removed = 0;
+    if (m_masked_runs != nullptr) {
+        size_type run = m_masked_runs->cuts_until(position);
+        if (run < m_masked_runs->size())
+            end = std::min(end, (size_type) m_masked_runs->get_cut(run));
+        removed = m_masked_runs->removed_before(run);
+    }
+
+    // records are kept in original positions, only runs cut before position move them,
+    // a record starting past the next cut ends no earlier than it
+    if (m_records != nullptr) {
+        Records::size_type record = m_records->find_record(position + removed);
+        if (record + 1 < m_records->size())
+            end = std::min(end, m_records->get_start(record + 1) - removed);
+    }
+
+    return end;
+}
+
+bool Index::skipped_word(size_type const position) const {
+    if (m_masked_runs == nullptr || !skips_cut_words())
+        return false;
+
+    size_type run = m_masked_runs->cuts_until(position);
+    return run < m_masked_runs->size() &&
+        m_masked_runs->get_cut(run) < std::min(position + m_word_size, m_text_length);
+}
+
+void Index::get_boundaries(std::vector<size_type> *boundaries) const {
+    boundaries->clear();
+    for (size_type i = 1; m_records != nullptr && i < m_records->size(); ++i) {
+        size_type start = m_records->get_start(i);
+        if (m_masked_runs != nullptr)
+            start = m_masked_runs->to_indexed(start);
+        if (start < m_text_length)
+            boundaries->push_back(start);
+    }
+
+    for (size_type run = 0; m_masked_runs != nullptr && run < m_masked_runs->size(); ++run) {
+        if (m_masked_runs->get_cut(run) < m_text_length)
+            boundaries->push_back(m_masked_runs->get_cut(run));
+    }
+    std::sort(boundaries->begin(), boundaries->end());
+}
+
+void Index::get_cuts(std::vector<size_type> *cuts) const {
+    cuts->clear();
+    for (size_type run = 0; m_masked_runs != nullptr && skips_cut_words() && run < m_masked_runs->size(); ++run)
+        cuts->push_back(m_masked_runs->get_cut(run));
+}
+
 int Index::count_exact_size_word(std::string const &pattern, size_type, ulong *numocc,
-                                 bool const locate, std::vector<ulong> *occ) const {
-    size_type word_value = m_alphabet->get_word_value(pattern, 0,
-                                                   m_word_size) + 1;
-    size_type position = m_select1->select(word_value) - word_value + 1;
-    size_type next_position = m_select1->select(word_value + 1) - word_value;
+                                 bool const locate, std::vector<ulong> *occ,
+                                 Slice const *slice) const {
+    size_type position, next_position;
+    if (slice != nullptr) {
+        position = slice->begin;
+        next_position = slice->end;
+    }
+    else {
+        get_bucket(m_alphabet->get_word_value(pattern, 0, m_word_size), &position, &next_position);
+    }
     *numocc = next_position - position;
 
-    if (locate) {
+    if (locate || verifies_buckets()) {
         verify_occurrences(position, next_position, pattern.length(),
                            0, numocc, occ);
     }
@@ -264,27 +786,24 @@ int Index::count_exact_size_word(std::string const &pattern, size_type, ulong *n
     return 0;
 }
 
-void Index::check_occ_end(std::string const &pattern, ulong *numocc) const {
-    if (m_additional_text_length == 0)
+void Index::check_occ_end(std::string const &pattern, std::vector<bool> const &right_side,
+                          ulong *numocc) const {
+    // a skipped last word gave no occurrences running into its padding
+    size_type last_word = (grid_words_number() - 1) * m_shift;
+    if (m_additional_text_length == 0 || pattern.length() > m_word_size || skipped_word(last_word))
         return;
 
+    // only buckets counted without decoding their cells may have counted the last word
+    // at an offset running into the padding, the same offsets count_short_* take whole
     value_type pattern_value = m_alphabet->get_word_value(pattern);
-    size_type length;
-    std::string extracted_text;
-    extract(m_text_length - pattern.length() + 1, m_text_length + m_additional_text_length,
-            &extracted_text, &length);
+    for (size_type offset = 0; offset < m_shift && offset + pattern.length() <= m_word_size; ++offset) {
+        bool whole_bucket = offset == 0 ? pattern.length() == m_word_size || right_side[0]
+                                        : !right_side[m_shift - offset];
 
-    value_type current_word_value = m_alphabet->get_word_value(extracted_text, 0,
-                                                               pattern.length());
-    value_type divisor = m_alphabet->pow_wsize(pattern.length() - 1);
-
-    for (size_type i = 0; i < m_additional_text_length; ++i) {
-        if (pattern_value == current_word_value) {
+        if (whole_bucket && last_word + offset + pattern.length() > m_text_length &&
+            pattern_value == extract_value(last_word + offset, pattern.length())) {
             --(*numocc);
         }
-
-        current_word_value %= divisor;
-        current_word_value *= m_alphabet->size();
     }
 }
 
@@ -294,244 +813,325 @@ void Index::add_last_occ(std::string const &pattern, bool const locate,
         return;
 
     size_type word_value = m_alphabet->get_word_value(pattern);
-    size_type word_position_index = m_permutation->get_size() * m_shift;
+    size_type word_position_index = grid_words_number() * m_shift;
     value_type extracted_value = extract_value(word_position_index,
                                                m_word_size - m_shift);
 
-    value_type modulo = m_alphabet->pow_wsize(m_word_size - m_shift);
-    value_type divisor = m_alphabet->pow_wsize(m_word_size - m_shift - pattern.length());
-
+    // word starting at i - m_shift is extracted_value % size^(m_word_size - i)
+    // without its last m_word_size - i - pattern.length() characters
     for (size_type i = m_shift; i + pattern.length() <= m_word_size; ++i) {
-        ulong current_value = extracted_value % modulo;
-        current_value /= divisor;
+        ulong current_value = m_alphabet->get_divisor(m_word_size - i).modulo(extracted_value);
+        current_value = m_alphabet->get_divisor(m_word_size - i - pattern.length()).divide(current_value);
 
         if (word_value == current_value &&
-            word_position_index + i - m_shift < m_text_length) {
+            in_segment(word_position_index + i - m_shift, pattern.length())) {
             (*numocc)++;
 
             if (locate) {
                 occ->push_back(word_position_index + i - m_shift);
             }
         }
-
-        divisor /= m_alphabet->size();
-        modulo /= m_alphabet->size();
     }
 }
 
-int Index::count_short_left(std::string const &pattern, bool const locate, ulong *numocc,
-                            std::vector<ulong> *occ) const {
+void Index::plan_short(std::string const &pattern, std::vector<bool> *right_side) const {
+    // estimated cost of a single select and of a single candidate verification
+    const size_type SELECT_COST = 1;
+    const size_type VERIFY_COST = 2;
 
     size_type start = (ulong) std::max(0, (int) (pattern.length() - m_word_size + 1));
+    size_type genome_words_number = m_permutation->get_size();
+
+    for (size_type i = start; i < m_shift; ++i) {
+        // i == 0 needs no verification on the right side, a word starting
+        // past the end of the pattern can be matched only from the left side
+        if (i == 0 || i >= pattern.length()) {
+            (*right_side)[i] = i == 0;
+            continue;
+        }
 
-    size_type left_index = 1;
-    value_type left_chunk_value = m_alphabet->get_word_value(pattern, 0,
-                                                        std::min(m_word_size - 1, pattern.length()));
-    if (pattern.length() < m_word_size - 1)
-        left_chunk_value *= m_alphabet->pow_wsize(m_word_size - pattern.length() - 1);
-
-    value_type right_chunk_value = 0;
-    if (m_word_size <= pattern.length())
-        right_chunk_value = m_alphabet->get_word_value(pattern, m_word_size - left_index,
-                                                       pattern.length());
-
-    value_type divisor = m_alphabet->pow_wsize(m_word_size - 1);
-    value_type lowest_divisor = divisor;
-    value_type multiplier = this->m_alphabet->size();
-
-    value_type limit = (m_shift - start) / 2;
-    if ((m_shift - start) % 2)
-        ++limit;
-    limit = m_shift - std::min((ulong) limit + start, (ulong) pattern.length());
-
-    for (size_type i = 0; i < limit; ++i) {
-        for (ulong k = 0; k < multiplier; ++k) {
-            value_type lower_bound = get_position_in_permutation(left_chunk_value +
-                k * lowest_divisor);
-
-            if (m_word_size - left_index < pattern.length()) {
-                value_type upper_bound = get_position_in_permutation(left_chunk_value +
-                    k * lowest_divisor + 1);
-
-                for (ulong j = lower_bound; j < upper_bound; ++j) {
-                    size_type word_position = m_permutation->pi(j);
-                    size_type word_position_index = word_position * m_shift;
-                    size_type right_chunk_length = pattern.length() - m_word_size + left_index;
-
-                    if (right_chunk_length > 0 &&
-                        word_position_index + m_word_size + right_chunk_length <= m_text_length + 1 &&
-                        right_chunk_value == extract_value(word_position_index + m_word_size,
-                                                           right_chunk_length)) {
-                        (*numocc)++;
-
-                        if (locate) {
-                            occ->push_back(word_position_index + left_index);
-                        }
-                    }
-                }
-            }
-            else {
-                value_type upper_bound = get_position_in_permutation((left_chunk_value +
-                    k * lowest_divisor) + m_alphabet->pow_wsize(m_word_size - left_index -
-                    pattern.length()));
-
-                *numocc += upper_bound - lower_bound;
-
-                if (locate) {
-                    verify_occurrences(lower_bound, upper_bound, pattern.length(),
-                                       left_index, numocc, occ);
-                }
+        value_type padding = m_alphabet->pow_wsize(i + m_word_size - pattern.length());
+        value_type right_value = m_alphabet->get_word_value(pattern, i, pattern.length()) * padding;
+        size_type right_cost = 2 * SELECT_COST + VERIFY_COST *
+            (get_position_in_permutation(right_value + padding) - get_position_in_permutation(right_value));
+
+        size_type left_index = m_shift - i;
+        size_type suffix_length = std::min(m_word_size - left_index, (size_type) pattern.length());
+        size_type tail_length = m_word_size - left_index - suffix_length;
+
+        value_type ranges = m_alphabet->pow_wsize(left_index);
+        if (m_suffix_directory != nullptr)
+            ranges = std::min(ranges, (value_type) m_alphabet->pow_wsize(tail_length));
+        size_type left_cost = 2 * SELECT_COST * ranges;
+
+        if (suffix_length < pattern.length()) {
+            size_type candidates = m_alphabet->get_divisor(suffix_length).divide(genome_words_number);
+            if (m_suffix_directory != nullptr) {
+                value_type range_size = m_alphabet->pow_wsize(left_index);
+                value_type reversed_value = m_alphabet->get_reversed_word_value(pattern, 0, suffix_length) *
+                    range_size;
+                candidates = m_suffix_directory->get_position(reversed_value + range_size) -
+                    m_suffix_directory->get_position(reversed_value);
             }
+            left_cost += VERIFY_COST * candidates;
         }
 
-        if (m_word_size - left_index - 1 < pattern.length())
-            right_chunk_value += m_alphabet->get_char_value(pattern[m_word_size - left_index - 1]) *
-                m_alphabet->pow_wsize(pattern.length() - m_word_size + left_index);
-
-        left_chunk_value /= this->m_alphabet->size();
-        multiplier *= this->m_alphabet->size();
-        ++left_index;
-        lowest_divisor /= m_alphabet->size();
+        (*right_side)[i] = right_cost <= left_cost;
     }
-
-    return 0;
 }
 
-int Index::count_short_right(std::string const &pattern, bool const locate, ulong *numocc,
-                             std::vector<ulong> *occ) const {
-    size_type start = (ulong) std::max(0, (int) (pattern.length() - m_word_size + 1));
-    value_type left_side_value = m_alphabet->get_word_value(pattern, 0, start);
-    value_type right_window_value = m_alphabet->get_word_value(pattern, start,
-                                                          pattern.length());
-
-    if (start + m_word_size > pattern.length()) {
-        right_window_value *= m_alphabet->pow_wsize(start + m_word_size -
-            pattern.length());
+int Index::save_index(std::ostream& out) const {
+    // section offsets are relative to the header, so an index can be saved inside another one
+    std::streampos start = out.tellp();
+    uint index_type = get_index_type();
+    uint sections_number = SECTIONS_NUMBER;
+    size_type sections[2 * SECTIONS_NUMBER] = {};
+
+    out.write((char *) &FILE_MAGIC, sizeof(uint));
+    out.write((char *) &FILE_VERSION, sizeof(uint));
+    out.write((char *) &index_type, sizeof(uint));
+    out.write((char *) &sections_number, sizeof(uint));
+    std::streampos table = out.tellp();
+    out.write((char *) sections, sizeof(sections));
+
+    for (uint i = 0; i < SECTIONS_NUMBER; ++i) {
+        sections[2 * i] = out.tellp() - start;
+        if (i == CORE_SECTION)
+            save_core(out);
+        else if (i == PERMUTATION_SECTION)
+            m_permutation->save(out);
+        else
+            save_text(out);
+        sections[2 * i + 1] = out.tellp() - start - sections[2 * i];
     }
 
-    value_type limit = (m_shift - start) / 2;
-    if ((m_shift - start) % 2)
-        ++limit;
-    limit = std::min((ulong) limit + start, (ulong) pattern.length());
-
-    value_type divisor = m_alphabet->pow_wsize(m_word_size - 1);
-
-    for (size_type i = start; i < limit; ++i) {
-        value_type right_window_value_bound = right_window_value +
-            m_alphabet->pow_wsize(i + m_word_size - pattern.length());
+    std::streampos end = out.tellp();
+    out.seekp(table);
+    out.write((char *) sections, sizeof(sections));
+    out.seekp(end);
 
-        value_type lower_bound = get_position_in_permutation(right_window_value);
-        value_type upper_bound = get_position_in_permutation(right_window_value_bound);
+    return 0;
+}
 
-        if (i == 0) {
-            *numocc += upper_bound - lower_bound;
+void Index::save_core(std::ostream& out) const {
+    out.write((char *) &m_word_size, sizeof(size_type));
+    out.write((char *) &m_shift, sizeof(size_type));
+    out.write((char *) &m_text_length, sizeof(size_type));
+    out.write((char *) &m_additional_text_length, sizeof(size_type));
 
-            if (locate) {
-                verify_occurrences(lower_bound, upper_bound, pattern.length(),
-                                   0, numocc, occ);
-            }
-        }
-        else {
-            for (ulong j = lower_bound; j < upper_bound; ++j) {
-                size_type word_position_index = m_permutation->pi(j) * m_shift;
+    m_alphabet->save(out);
+    m_directory->save(out);
+
+    bool has_qgram_table = m_qgram_table != nullptr;
+    out.write((char *) &has_qgram_table, sizeof(bool));
+    if (has_qgram_table)
+        m_qgram_table->save(out);
+
+    bool has_suffix_directory = m_suffix_directory != nullptr;
+    out.write((char *) &has_suffix_directory, sizeof(bool));
+    if (has_suffix_directory)
+        m_suffix_directory->save(out);
+
+    bool has_repeat_buckets = m_repeat_buckets != nullptr;
+    out.write((char *) &has_repeat_buckets, sizeof(bool));
+    if (has_repeat_buckets)
+        m_repeat_buckets->save(out);
+
+    bool has_masked_runs = m_masked_runs != nullptr && !m_shared_boundaries;
+    out.write((char *) &has_masked_runs, sizeof(bool));
+    if (has_masked_runs)
+        m_masked_runs->save(out);
+
+    bool has_records = m_records != nullptr && !m_shared_boundaries;
+    out.write((char *) &has_records, sizeof(bool));
+    if (has_records)
+        m_records->save(out);
+
+    bool has_colocated_directory = m_colocated_directory != nullptr;
+    out.write((char *) &has_colocated_directory, sizeof(bool));
+    if (has_colocated_directory)
+        m_colocated_directory->save(out);
+
+    bool has_pair_filter = m_pair_filter != nullptr;
+    out.write((char *) &has_pair_filter, sizeof(bool));
+    if (has_pair_filter)
+        m_pair_filter->save(out);
+}
 
-                if (word_position_index >= i &&
-                    word_position_index + i <= m_text_length + 1 &&
-                    left_side_value == extract_value(word_position_index - i, i)) {
-                    ++(*numocc);
+void Index::load_core(std::istream &in) {
+    in.read((char *) &m_word_size, sizeof(size_type));
+    in.read((char *) &m_shift, sizeof(size_type));
+    in.read((char *) &m_text_length, sizeof(size_type));
+    in.read((char *) &m_additional_text_length, sizeof(size_type));
 
-                    if (locate) {
-                        occ->push_back(word_position_index - i);
-                    }
-                }
+    m_alphabet = Alphabet::load(in);
 
-            }
+    m_directory = BucketDirectory::load(in);
+    m_directory_type = m_directory->get_type();
+
+    bool has_qgram_table;
+    in.read((char *) &has_qgram_table, sizeof(bool));
+    m_qgram_table = has_qgram_table ? QGramTable::load(in) : nullptr;
+
+    bool has_suffix_directory;
+    in.read((char *) &has_suffix_directory, sizeof(bool));
+    m_suffix_directory = has_suffix_directory ? SuffixDirectory::load(in, m_file_version) : nullptr;
+
+    bool has_repeat_buckets;
+    in.read((char *) &has_repeat_buckets, sizeof(bool));
+    m_repeat_buckets = has_repeat_buckets ? RepeatBuckets::load(in) : nullptr;
+
+    bool has_masked_runs;
+    in.read((char *) &has_masked_runs, sizeof(bool));
+    m_masked_runs = has_masked_runs ? MaskedRuns::load(in) : nullptr;
+
+    // version 1 ends with the flag of Elias-Fano permutations, which are not built any
+    // more, and kept words spanning cuts in the permutations of every index type
+    if (m_file_version == 1) {
+        bool compressed_permutation;
+        in.read((char *) &compressed_permutation, sizeof(bool));
+        if (compressed_permutation || (has_masked_runs && skips_cut_words())) {
+            std::cerr << "Index of version 1 can't be converted, rebuild it.\n";
+            throw std::runtime_error("Unsupported index.");
         }
 
-        right_window_value %= divisor;
-        right_window_value *= m_alphabet->size();
-        left_side_value *= m_alphabet->size();
-        left_side_value += m_alphabet->get_char_value(pattern[i]);
+        m_records = nullptr;
+        m_colocated_directory = nullptr;
+        m_pair_filter = nullptr;
+        return;
     }
 
-    return 0;
-}
-
-int Index::count_short(std::string const &pattern, ulong length,
-                       bool const locate, ulong *numocc, std::vector<ulong> *occ) const {
-    length = std::min(m_text_length, length);
+    bool has_records;
+    in.read((char *) &has_records, sizeof(bool));
+    m_records = has_records ? Records::load(in) : nullptr;
 
-    if (pattern.length() >= m_word_size)
-        count_full_words(pattern, length, locate, numocc, occ);
+    bool has_colocated_directory;
+    in.read((char *) &has_colocated_directory, sizeof(bool));
+    m_colocated_directory = has_colocated_directory ? ColocatedDirectory::load(in, m_file_version) : nullptr;
 
-    count_short_right(pattern, locate, numocc, occ);
-    count_short_left(pattern, locate, numocc, occ);
+    bool has_pair_filter;
+    in.read((char *) &has_pair_filter, sizeof(bool));
+    m_pair_filter = has_pair_filter ? PairFilter::load(in, m_file_version) : nullptr;
+}
 
-    add_last_occ(pattern, locate, numocc, occ);
-    if (!locate) {
-        check_occ_end(pattern, numocc);
+void Index::load(std::istream &in) {
+    std::streampos start = in.tellg();
+    size_type sections[2 * SECTIONS_NUMBER];
+    if (read_header(in, sections, &m_file_version) != get_index_type()) {
+        std::cerr << "Wrong index type!\n";
     }
 
-    return 0;
+    in.seekg(start + (std::streamoff) sections[2 * CORE_SECTION]);
+    load_core(in);
+    in.seekg(start + (std::streamoff) sections[2 * PERMUTATION_SECTION]);
+    m_permutation = load_permutation(in);
+    in.seekg(start + (std::streamoff) sections[2 * TEXT_SECTION]);
+    load_text(in);
+
+    in.seekg(start + (std::streamoff) (sections[2 * TEXT_SECTION] + sections[2 * TEXT_SECTION + 1]));
 }
 
-int Index::save_index(std::ostream& out) const {
-    out.write((char *) &m_word_size, sizeof(size_type));
-    out.write((char *) &m_shift, sizeof(size_type));
-    out.write((char *) &m_text_length, sizeof(size_type));
-    out.write((char *) &m_additional_text_length, sizeof(size_type));
+uint Index::read_header(std::istream &in, size_type *sections, uint *version) {
+    uint magic = 0, index_type = 0, sections_number = 0;
+    *version = 0;
+    in.read((char *) &magic, sizeof(uint));
+    in.read((char *) version, sizeof(uint));
+    in.read((char *) &index_type, sizeof(uint));
+    in.read((char *) &sections_number, sizeof(uint));
 
-    m_alphabet->save(out);
-    m_bit_vector->serialize(out);
-    m_rank1->serialize(out);
-    m_select1->serialize(out);
-    m_permutation->save(out);
+    // version 1 keeps permutation cells in 32-bit words, which are converted on load, and
+    // lacks records, the colocated directory and the pair filter
+    if (magic != FILE_MAGIC || *version < 1 || *version > FILE_VERSION || sections_number != SECTIONS_NUMBER) {
+        std::cerr << "Couldn't load index from file, wrong format.";
+        throw std::runtime_error("Wrong file.");
+    }
 
-    return 0;
+    in.read((char *) sections, 2 * SECTIONS_NUMBER * sizeof(size_type));
+
+    return index_type;
 }
-void Index::load(std::istream &in) {
-    in.read((char *) &m_word_size, sizeof(size_type));
-    in.read((char *) &m_shift, sizeof(size_type));
-    in.read((char *) &m_text_length, sizeof(size_type));
-    in.read((char *) &m_additional_text_length, sizeof(size_type));
 
-    m_alphabet = Alphabet::load(in);
+Index *Index::create_index(uint const index_type) {
+    if (index_type == IndexBitVector::INDEX_TYPE)
+        return new IndexBitVector();
+    if (index_type == IndexPerm::INDEX_TYPE)
+        return new IndexPerm();
+    if (index_type == IndexWaveletTree::INDEX_TYPE)
+        return new IndexWaveletTree();
+    if (index_type == IndexDna::INDEX_TYPE)
+        return new IndexDna();
+    if (index_type == IndexMinimizer::INDEX_TYPE)
+        return new IndexMinimizer();
+    if (index_type == IndexTwoLevel::INDEX_TYPE)
+        return new IndexTwoLevel();
+
+    std::cerr << "Couldn't load index from file, wrong format.";
+    throw std::runtime_error("Wrong file.");
+}
 
-    m_bit_vector = new sdsl::bit_vector();
-    m_bit_vector->load(in);
+Index *Index::load_index(std::istream &in) {
+    std::streampos start = in.tellg();
+    size_type sections[2 * SECTIONS_NUMBER];
+    uint version;
+    uint index_type = read_header(in, sections, &version);
+    in.seekg(start);
 
-    m_rank1 = new sdsl::bit_vector::rank_1_type();
-    m_rank1->load(in, m_bit_vector);
+    Index *result = create_index(index_type);
+    result->load(in);
 
-    m_select1 = new sdsl::bit_vector::select_1_type;
-    m_select1->load(in, m_bit_vector);
+    return result;
 }
 
-Index *Index::load_index(std::istream &in) {
-    uint index_type;
-    in.read((char *) &index_type, sizeof(uint));
-    int position = (int) in.tellg() - sizeof(uint);
-    in.seekg(position);
-
-    Index *result = nullptr;
-    if (index_type == IndexBitVector::INDEX_TYPE) {
-        result = new IndexBitVector();
-        result->load(in);
-    }
-    else if (index_type == IndexPerm::INDEX_TYPE) {
-        result = new IndexPerm();
-        result->load(in);
+Index *Index::map_index(char const *filename) {
+    MappedFile *file = new MappedFile();
+    if (file->open(filename) != 0) {
+        delete file;
+        throw std::runtime_error("Wrong file.");
     }
-    else if (index_type == IndexWaveletTree::INDEX_TYPE) {
-        result = new IndexWaveletTree();
-        result->load(in);
+
+    MappedBuffer buffer(file->data(), file->size());
+    std::istream in(&buffer);
+
+    Index *result;
+    try {
+        size_type sections[2 * SECTIONS_NUMBER];
+        uint version;
+        result = create_index(read_header(in, sections, &version));
+        std::copy(sections, sections + 2 * SECTIONS_NUMBER, result->m_sections);
+        result->m_file_version = version;
     }
-    else {
-        std::cerr << "Couldn't load index from file, wrong format.";
-        throw std::runtime_error("Wrong file.");
+    catch (...) {
+        delete file;
+        throw;
     }
 
+    // only the core is read now, the rest waits for load_sections
+    in.seekg(result->m_sections[2 * CORE_SECTION]);
+    result->load_core(in);
+    result->m_mapped_file = file;
+    result->m_deferred_sections = true;
+
     return result;
 }
 
+void Index::load_sections() const {
+    if (!m_deferred_sections)
+        return;
+
+    // queries may run in parallel on a shared index, the first one reads the sections
+    std::call_once(m_sections_loaded, [this]() {
+        const_cast<Index *>(this)->read_sections();
+    });
+}
+
+void Index::read_sections() {
+    MappedBuffer buffer(m_mapped_file->data(), m_mapped_file->size());
+    std::istream in(&buffer);
+
+    in.seekg(m_sections[2 * PERMUTATION_SECTION]);
+    m_permutation = load_permutation(in);
+    in.seekg(m_sections[2 * TEXT_SECTION]);
+    load_text(in);
+}
+
 }
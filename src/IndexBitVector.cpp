@@ -14,7 +14,6 @@
     along with this program.  If not, see http://www.gnu.org/licenses/ .
 */
 
-
 #include "IndexBitVector.hpp"
 
 namespace cdat {
@@ -22,20 +21,22 @@ namespace cdat {
 uint const IndexBitVector::INDEX_TYPE = 128;
 
 IndexBitVector::IndexBitVector(size_type word_size, size_type shift) :
-    Index(word_size, shift) {}
+    Index(word_size, shift), m_text(nullptr), m_shared_text(false) {}
+
+IndexBitVector::IndexBitVector(size_type word_size, size_type shift, sdsl::int_vector<> *shared_text) :
+    Index(word_size, shift), m_text(shared_text), m_shared_text(true) {}
 
 IndexBitVector::IndexBitVector(size_type word_size, size_type shift, size_type text_length,
-                               size_type additional_text_length, sdsl::bit_vector *bit_vector,
-                               sdsl::bit_vector::rank_1_type *rank1,
-                               sdsl::bit_vector::select_1_type *select1,
+                               size_type additional_text_length, BucketDirectory *directory,
                                Permutation *permutation, Alphabet *alphabet, sdsl::int_vector<> *text) :
 
     Index(word_size, shift, text_length, additional_text_length,
-          bit_vector, rank1, select1, permutation, alphabet),
-    m_text(text) {}
+          directory, permutation, alphabet),
+    m_text(text), m_shared_text(false) {}
 
 IndexBitVector::~IndexBitVector() {
-    delete m_text;
+    if (!m_shared_text)
+        delete m_text;
 }
 
 bool IndexBitVector::check_word(size_type const position, size_type const length, const char *pattern) const {
@@ -50,9 +51,10 @@ bool IndexBitVector::check_word(size_type const position, size_type const length
 
 int IndexBitVector::count_full_words(std::string const &pattern, ulong length,
                                      bool const locate, ulong *numocc,
-                                     std::vector<ulong> *occ) const {
+                                     std::vector<ulong> *occ,
+                                     Slice const *slice) const {
     if (pattern.length() == m_word_size) {
-        return count_exact_size_word(pattern, length, numocc, locate, occ);
+        return count_exact_size_word(pattern, length, numocc, locate, occ, slice);
     }
 
     size_type start = 0;
@@ -60,19 +62,18 @@ int IndexBitVector::count_full_words(std::string const &pattern, ulong length,
     if (m_word_size + m_shift - 1 > pattern.length())
         limit = pattern.length() - m_word_size + 1;
 
+    std::vector<value_type> positions;
     while (start < limit) {
         size_type word_value = m_alphabet->get_word_value(pattern, start,
                                                           start + m_word_size) + 1;
-        size_t position = m_select1->select(word_value) - word_value + 1;
-        size_t next_position = m_select1->select(word_value + 1) - word_value;
-
-        for (ulong i = position; i < next_position; ++i) {
+        decode_scan(word_value - 1, pattern, start, slice, &positions);
+        for (ulong i = 0; i < positions.size(); ++i) {
             size_type right_end = start + m_word_size;
-            size_type curr_word_position = m_permutation->pi(i);
+            size_type curr_word_position = positions[i];
             size_type word_index_position = curr_word_position * m_shift;
 
             if ((word_index_position < start) ||
-                (m_text_length < (word_index_position + m_word_size) +
+                (segment_end(word_index_position - start) < (word_index_position + m_word_size) +
                     (pattern.length() - right_end)))
                 continue;
 
@@ -106,21 +107,25 @@ int IndexBitVector::count_full_words(std::string const &pattern, ulong length,
 
 IndexBitVector::value_type IndexBitVector::extract_value(size_type const from,
                                                          size_type const length) const{
-    value_type result = 0;
-    size_type to = from + length;
-    size_type start = from;
+    return extract_packed_value<0>(from, length);
+}
 
-    while (start < to) {
-        result *= m_alphabet->size();
-        result += (*m_text)[start];
-        ++start;
+int IndexBitVector::count_short(std::string const &pattern, ulong length,
+                                bool const locate, ulong *numocc,
+                                std::vector<ulong> *occ) const {
+    if (m_alphabet->size() == 4) {
+        return count_short_kernel(pattern, length, [this](size_type from, size_type length) {
+            return extract_packed_value<4>(from, length);
+        }, locate, numocc, occ);
     }
 
-    return result;
+    return count_short_kernel(pattern, length, [this](size_type from, size_type length) {
+        return extract_packed_value<0>(from, length);
+    }, locate, numocc, occ);
 }
 
-int IndexBitVector::extract(ulong const from, ulong const to,
-                            std::string *text, ulong *length) const {
+int IndexBitVector::extract_text(ulong const from, ulong const to,
+                                 std::string *text, ulong *length) const {
     ulong _to = std::min(to, m_text_length);
     if (_to < from) {
         *length = 0;
@@ -140,24 +145,14 @@ int IndexBitVector::extract(ulong const from, ulong const to,
     return 0;
 }
 
-int IndexBitVector::save_index(std::ostream& out) const {
-    out.write((char *) &IndexBitVector::INDEX_TYPE, sizeof(uint));
-    Index::save_index(out);
-    m_text->serialize(out);
-
-    return 0;
+void IndexBitVector::save_text(std::ostream& out) const {
+    if (!m_shared_text)
+        m_text->serialize(out);
 }
 
-void IndexBitVector::load(std::istream& in) {
-    uint index_type;
-    in.read((char *) &index_type, sizeof(uint));
-
-    if (index_type != INDEX_TYPE) {
-        std::cerr << "Wrong index type!\n";
-    }
-
-    Index::load(in);
-    m_permutation = Permutation::load(in);
+void IndexBitVector::load_text(std::istream& in) {
+    if (m_shared_text)
+        return;
 
     m_text = new sdsl::int_vector<>(m_text_length + m_additional_text_length, 0,
                                     (uint8_t) cds_utils::bits((uint) m_alphabet->size()));
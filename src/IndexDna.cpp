@@ -0,0 +1,170 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+#include "IndexDna.hpp"
+
+namespace cdat {
+
+uint const IndexDna::INDEX_TYPE = 1024;
+IndexDna::size_type const IndexDna::BASES_PER_WORD;
+
+IndexDna::IndexDna(size_type word_size, size_type shift) :
+    Index(word_size, shift), m_text(nullptr) {}
+
+IndexDna::IndexDna(size_type word_size, size_type shift, size_type text_length,
+                   size_type additional_text_length, BucketDirectory *directory,
+                   Permutation *permutation, Alphabet *alphabet, sdsl::int_vector<64> *text) :
+
+    Index(word_size, shift, text_length, additional_text_length,
+          directory, permutation, alphabet),
+    m_text(text) {}
+
+IndexDna::~IndexDna() {
+    delete m_text;
+}
+
+int IndexDna::create_alphabet(char const *filename) {
+    if (Index::create_alphabet(filename) != 0)
+        return -1;
+
+    std::string const bases = "ACGT";
+    for (value_type i = 0; i < m_alphabet->size(); ++i) {
+        if (bases.find(m_alphabet->get_char_from_value(i)) == std::string::npos) {
+            std::cerr << "Error: dna index requires text over A, C, G and T only\n";
+            return -1;
+        }
+    }
+
+    // text may miss some of the bases, values have to stay two bits wide anyway
+    delete m_alphabet;
+    m_alphabet = new Alphabet();
+    m_alphabet->build_from_characters(bases);
+
+    return 0;
+}
+
+void IndexDna::pack_pattern(std::string const &pattern, Alphabet const *alphabet,
+                            std::vector<uint64_t> *packed) {
+    packed->assign(pattern.length() / BASES_PER_WORD + 2, 0);
+
+    for (size_type i = 0; i < pattern.length(); ++i) {
+        (*packed)[i / BASES_PER_WORD] |= (uint64_t) alphabet->get_char_value(pattern[i]) <<
+            (62 - 2 * (i % BASES_PER_WORD));
+    }
+}
+
+bool IndexDna::check_word(size_type const position, size_type const length,
+                          std::vector<uint64_t> const &pattern,
+                          size_type const pattern_position) const {
+    for (size_type i = 0; i < length; i += BASES_PER_WORD) {
+        size_type chunk = std::min(BASES_PER_WORD, length - i);
+        if (packed_value(m_text->data(), position + i, chunk) !=
+            packed_value(pattern.data(), pattern_position + i, chunk))
+            return false;
+    }
+
+    return true;
+}
+
+int IndexDna::count_short(std::string const &pattern, ulong length,
+                          bool const locate, ulong *numocc,
+                          std::vector<ulong> *occ) const {
+    return count_short_kernel(pattern, length, [this](size_type from, size_type length) {
+        return IndexDna::extract_value(from, length);
+    }, locate, numocc, occ);
+}
+
+int IndexDna::count_full_words(std::string const &pattern, ulong length,
+                               bool const locate, ulong *numocc,
+                               std::vector<ulong> *occ,
+                               Slice const *slice) const {
+    if (pattern.length() == m_word_size) {
+        return count_exact_size_word(pattern, length, numocc, locate, occ, slice);
+    }
+
+    std::vector<uint64_t> packed_pattern;
+    pack_pattern(pattern, m_alphabet, &packed_pattern);
+
+    size_type start = 0;
+    size_type limit = m_shift;
+    if (m_word_size + m_shift - 1 > pattern.length())
+        limit = pattern.length() - m_word_size + 1;
+
+    std::vector<value_type> positions;
+    while (start < limit) {
+        // bases are packed in alphabet order, so the packed bits are the word value,
+        // word size is at most 32 as 4^size buckets have to be addressable
+        size_type word_value = packed_value(packed_pattern.data(), start, m_word_size);
+        decode_scan(word_value, pattern, start, slice, &positions);
+        for (ulong i = 0; i < positions.size(); ++i) {
+            size_type right_end = start + m_word_size;
+            size_type word_index_position = positions[i] * m_shift;
+
+            if ((word_index_position < start) ||
+                (segment_end(word_index_position - start) < (word_index_position + m_word_size) +
+                    (pattern.length() - right_end)))
+                continue;
+
+            if (start != 0 &&
+                !check_word(word_index_position - start, start, packed_pattern, 0))
+                continue;
+
+            if (right_end < pattern.length() &&
+                !check_word(word_index_position + m_word_size, pattern.length() - right_end,
+                            packed_pattern, right_end))
+                continue;
+
+            if (locate) {
+                occ->push_back(word_index_position - start);
+            }
+
+            (*numocc)++;
+        }
+
+        ++start;
+    }
+
+    return 0;
+}
+
+int IndexDna::extract_text(ulong const from, ulong const to,
+                           std::string *text, ulong *length) const {
+    ulong _to = std::min(to, m_text_length);
+    if (_to < from) {
+        *length = 0;
+        return -1;
+    }
+
+    *length = to - from;
+    text->reserve(*length);
+
+    for (ulong i = 0; i < *length; ++i) {
+        *text += m_alphabet->get_char_from_value(packed_value(m_text->data(), from + i, 1));
+    }
+
+    return 0;
+}
+
+void IndexDna::save_text(std::ostream& out) const {
+    m_text->serialize(out);
+}
+
+void IndexDna::load_text(std::istream& in) {
+    m_text = new sdsl::int_vector<64>();
+    m_text->load(in);
+}
+
+}
@@ -0,0 +1,285 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+#include "IndexMinimizer.hpp"
+
+namespace cdat {
+
+uint const IndexMinimizer::INDEX_TYPE = 2048;
+
+IndexMinimizer::IndexMinimizer(size_type word_size, size_type window) :
+    Index(word_size, window), m_text(nullptr) {}
+
+IndexMinimizer::~IndexMinimizer() {
+    delete m_text;
+}
+
+int IndexMinimizer::build(char const *filename) {
+#ifdef DEBUG
+    timeval start_now, start;
+    gettimeofday(&start, NULL);
+    gettimeofday(&start_now, NULL);
+#endif
+
+    if (create_alphabet(filename) != 0) {
+        return -1;
+    }
+
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: unable to open file\n";
+        return -1;
+    }
+
+    file.seekg(0, std::ios::end);
+    m_text_length = (size_type) file.tellg();
+    m_additional_text_length = 0;
+    file.seekg(0, std::ios::beg);
+
+    m_text = new sdsl::int_vector<>(m_text_length, 0,
+                                    (uint8_t) cds_utils::bits((uint) (m_alphabet->size() - 1)));
+    size_type char_counter = 0;
+    const size_t BUFFER_SIZE = 16 * 1024;
+    char buffer[BUFFER_SIZE];
+    size_t bytes_read;
+    do {
+        file.read(buffer, BUFFER_SIZE);
+        bytes_read = (size_t) file.gcount();
+
+        for (size_t i = 0; i < bytes_read; ++i) {
+            (*m_text)[char_counter++] = m_alphabet->get_char_value(buffer[i]);
+        }
+    }
+    while (bytes_read == BUFFER_SIZE);
+#ifdef DEBUG
+    print_time(start_now, "text time: ");
+#endif
+
+    size_type words_number = m_alphabet->pow_wsize(m_word_size);
+    size_type sampled_words_number = 0;
+    Counter<32> counter(words_number);
+    for (size_type i = 0; i < words_number; ++i)
+        counter.set(i, 0);
+
+    for_each_minimizer([&](size_type, value_type word_value) {
+        counter.inc(word_value);
+        ++sampled_words_number;
+    });
+    create_bit_vector(counter, words_number, sampled_words_number);
+
+    if (m_build_qgram_table) {
+        std::vector<size_type> boundaries;
+        get_boundaries(&boundaries);
+        m_qgram_table = new QGramTable();
+        m_qgram_table->build(file, m_word_size - 1, m_alphabet, boundaries);
+    }
+
+    // buckets keep text positions, so cells are as wide as the text length needs
+    size_type cell_size = cds_utils::bits(std::max(m_text_length, (size_type) 1) - 1);
+    m_permutation = new Permutation(sampled_words_number, cell_size);
+    counter.prepare_for_permutation();
+    for_each_minimizer([&](size_type position, value_type word_value) {
+        m_permutation->set_field(counter.get_and_inc(word_value), position);
+    });
+#ifdef DEBUG
+    print_time(start_now, "minimizers time: ");
+    print_time(start, "index build time: ");
+#endif
+
+    return 0;
+}
+
+IndexMinimizer::size_type IndexMinimizer::window_minimizer(size_type const position) const {
+    size_type last = std::min(position + m_shift - 1, m_text_length - m_word_size);
+    size_type result = position;
+    value_type result_order = word_order(extract_value(position, m_word_size));
+
+    for (size_type i = position + 1; i <= last; ++i) {
+        value_type order = word_order(extract_value(i, m_word_size));
+        if (order < result_order) {
+            result = i;
+            result_order = order;
+        }
+    }
+
+    return result;
+}
+
+IndexMinimizer::size_type IndexMinimizer::pattern_minimizer(std::string const &pattern) const {
+    size_type result = 0;
+    value_type result_order = word_order(m_alphabet->get_word_value(pattern, 0, m_word_size));
+
+    for (size_type i = 1; i < m_shift; ++i) {
+        value_type order = word_order(m_alphabet->get_word_value(pattern, i, i + m_word_size));
+        if (order < result_order) {
+            result = i;
+            result_order = order;
+        }
+    }
+
+    return result;
+}
+
+bool IndexMinimizer::check_word(size_type const position, size_type const length,
+                                const char *pattern) const {
+    for (size_type i = 0; i < length; ++i) {
+        if (pattern[i] != m_alphabet->get_char_from_value((*m_text)[position + i]))
+            return false;
+    }
+
+    return true;
+}
+
+int IndexMinimizer::count_full_words(std::string const &pattern, ulong,
+                                     bool const locate, ulong *numocc,
+                                     std::vector<ulong> *occ,
+                                     Slice const *) const {
+    size_type offset = pattern_minimizer(pattern);
+    value_type word_value = m_alphabet->get_word_value(pattern, offset, offset + m_word_size);
+
+    std::vector<value_type> positions;
+    m_permutation->decode_range(get_position_in_permutation(word_value),
+                                get_position_in_permutation(word_value + 1), &positions);
+
+    for (ulong i = 0; i < positions.size(); ++i) {
+        if (positions[i] < offset ||
+            positions[i] - offset + pattern.length() > segment_end(positions[i] - offset))
+            continue;
+
+        size_type position = positions[i] - offset;
+        if (!check_word(position, offset, pattern.c_str()) ||
+            !check_word(position + offset + m_word_size, pattern.length() - offset - m_word_size,
+                        pattern.c_str() + offset + m_word_size))
+            continue;
+
+        if (locate) {
+            occ->push_back(position);
+        }
+
+        (*numocc)++;
+    }
+
+    return 0;
+}
+
+int IndexMinimizer::count_short(std::string const &pattern, ulong,
+                                bool const locate, ulong *numocc,
+                                std::vector<ulong> *occ) const {
+    if (pattern.length() > m_text_length)
+        return 0;
+
+    // no sampled word has to start inside occurrences shorter than the window, they
+    // cost a scan of the whole text, see the -f help of cdat_build
+    if (pattern.length() < m_shift || m_text_length < m_word_size) {
+        count_scan(pattern, 0, m_text_length - pattern.length() + 1, locate, numocc, occ);
+        return 0;
+    }
+
+    // orders of words lying inside the pattern, the minimizer of an occurrence
+    // starting at offset i has to be smaller than all of them
+    size_type whole_words = pattern.length() >= m_word_size ?
+        std::min(m_shift, (size_type) (pattern.length() - m_word_size + 1)) : 0;
+    std::vector<value_type> orders(whole_words);
+    for (size_type i = 0; i < whole_words; ++i)
+        orders[i] = word_order(m_alphabet->get_word_value(pattern, i, i + m_word_size));
+
+    std::vector<value_type> positions;
+    for (size_type i = 0; i < m_shift; ++i) {
+        bool minimal = true;
+        for (size_type j = 0; i < whole_words && j < whole_words; ++j) {
+            if (j < i ? orders[j] <= orders[i] : orders[j] < orders[i])
+                minimal = false;
+        }
+        if (!minimal)
+            continue;
+
+        // words starting at offset i with the rest of the pattern as prefix
+        size_type prefix_length = std::min(m_word_size, (size_type) pattern.length() - i);
+        value_type padding = m_alphabet->pow_wsize(m_word_size - prefix_length);
+        value_type word_value = m_alphabet->get_word_value(pattern, i, i + prefix_length) * padding;
+
+        m_permutation->decode_range(get_position_in_permutation(word_value),
+                                    get_position_in_permutation(word_value + padding), &positions);
+
+        for (ulong j = 0; j < positions.size(); ++j) {
+            if (positions[j] < i || positions[j] - i + pattern.length() > segment_end(positions[j] - i))
+                continue;
+
+            // every occurrence is reported only by the minimizer of its first window
+            size_type position = positions[j] - i;
+            if (!check_word(position, pattern.length(), pattern.c_str()) ||
+                window_minimizer(position) != positions[j])
+                continue;
+
+            if (locate) {
+                occ->push_back(position);
+            }
+
+            (*numocc)++;
+        }
+    }
+
+    // occurrences starting after the last word of the text
+    size_type tail = m_text_length - m_word_size + 1;
+    if (tail + pattern.length() <= m_text_length)
+        count_scan(pattern, tail, m_text_length - pattern.length() + 1, locate, numocc, occ);
+
+    return 0;
+}
+
+void IndexMinimizer::count_scan(std::string const &pattern, size_type const from, size_type const to,
+                                bool const locate, ulong *numocc, std::vector<ulong> *occ) const {
+    for (size_type position = from; position < to; ++position) {
+        if (!check_word(position, pattern.length(), pattern.c_str()) ||
+            position + pattern.length() > segment_end(position))
+            continue;
+
+        if (locate) {
+            occ->push_back(position);
+        }
+
+        (*numocc)++;
+    }
+}
+
+int IndexMinimizer::extract_text(ulong const from, ulong const to,
+                                 std::string *text, ulong *length) const {
+    ulong _to = std::min(to, m_text_length);
+    if (_to < from) {
+        *length = 0;
+        return -1;
+    }
+
+    *length = _to - from;
+    text->reserve(*length);
+
+    for (ulong i = 0; i < *length; ++i) {
+        *text += m_alphabet->get_char_from_value((*m_text)[from + i]);
+    }
+
+    return 0;
+}
+
+void IndexMinimizer::save_text(std::ostream& out) const {
+    m_text->serialize(out);
+}
+
+void IndexMinimizer::load_text(std::istream& in) {
+    m_text = new sdsl::int_vector<>();
+    m_text->load(in);
+}
+
+}
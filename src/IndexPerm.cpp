@@ -14,7 +14,6 @@
     along with this program.  If not, see http://www.gnu.org/licenses/ .
 */
 
-
 #include "IndexPerm.hpp"
 
 namespace cdat {
@@ -22,24 +21,29 @@ namespace cdat {
 uint const IndexPerm::INDEX_TYPE = 256;
 
 IndexPerm::IndexPerm(size_type word_size, size_type shift) :
-    Index(word_size, shift) {}
+    Index(word_size, shift), m_inverse_sampling(0) {}
 
 IndexPerm::IndexPerm(size_type word_size, size_type shift, size_type text_length,
-                     size_type additional_text_length, sdsl::bit_vector *bit_vector,
-                     sdsl::bit_vector::rank_1_type *rank1,
-                     sdsl::bit_vector::select_0_type *select0,
-                     sdsl::bit_vector::select_1_type *select1,
+                     size_type additional_text_length, BucketDirectory *directory,
                      Permutation *permutation, Alphabet *alphabet) :
 
     Index(word_size, shift, text_length, additional_text_length,
-          bit_vector, rank1, select1, permutation, alphabet), m_select0(select0) {}
+          directory, permutation, alphabet), m_inverse_sampling(0) {}
 
 IndexPerm::~IndexPerm() {
 }
 
-void IndexPerm::create_bit_vector_support() {
-    Index::create_bit_vector_support();
-    m_select0 = new sdsl::bit_vector::select_0_type(m_bit_vector);
+void IndexPerm::create_bit_vector_support(sdsl::bit_vector const &bit_vector) {
+    m_directory = BucketDirectory::create(m_directory_type, bit_vector, true);
+}
+
+void IndexPerm::complete_permutation() {
+    if (m_inverse_sampling == 0)
+        return;
+
+    Permutation *permutation = new SampledRevPermutation(m_permutation, m_inverse_sampling);
+    delete m_permutation;
+    m_permutation = permutation;
 }
 
 void IndexPerm::count_right_side_values(
@@ -52,11 +56,13 @@ void IndexPerm::count_right_side_values(
     }
 }
 
-int IndexPerm::count_full_words(std::string const &pattern, ulong length,
-                                bool const locate, ulong *numocc,
-                                std::vector<ulong> *occ) const {
+template<class t_permutation>
+int IndexPerm::count_full_words_kernel(std::string const &pattern, ulong length,
+                                       bool const locate, ulong *numocc,
+                                       std::vector<ulong> *occ,
+                                       Slice const *slice) const {
     if (pattern.length() == m_word_size) {
-        return count_exact_size_word(pattern, length, numocc, locate, occ);
+        return count_exact_size_word(pattern, length, numocc, locate, occ, slice);
     }
 
     size_t left_side_value = 0;
@@ -72,30 +78,29 @@ int IndexPerm::count_full_words(std::string const &pattern, ulong length,
         limit = pattern.length() - m_word_size + 1;
 
     uint start = 0;
+    std::vector<value_type> positions;
     while (start < limit) {
         size_t word_value = m_alphabet->get_word_value(pattern, start,
                                                        start + m_word_size) + 1;
-        size_t position = m_select1->select(word_value) - word_value + 1;
-        size_t next_position = m_select1->select(word_value + 1) - word_value;
-
-        for (ulong i = position; i < next_position; ++i) {
+        decode_scan(word_value - 1, pattern, start, slice, &positions);
+        for (ulong i = 0; i < positions.size(); ++i) {
             size_type right_end = start + m_word_size;
-            size_type curr_word_position = m_permutation->pi(i);
+            size_type curr_word_position = positions[i];
             size_type word_index_position = curr_word_position * m_shift;
 
             if ((word_index_position < start) ||
-                (m_text_length < (word_index_position + m_word_size) +
+                (segment_end(word_index_position - start) < (word_index_position + m_word_size) +
                     (pattern.length() - right_end)))
                 continue;
 
             if (start != 0) {
-                if (left_side_value != extract_value(word_index_position - start, start)) {
+                if (left_side_value != extract_value_kernel<t_permutation>(word_index_position - start, start)) {
                     continue;
                 }
             }
 
             if (start + m_word_size < pattern.length()) {
-                if (!check_and_extract_value(word_index_position, array_size, right_side_values))
+                if (!check_and_extract_value<t_permutation>(word_index_position, array_size, right_side_values))
                     continue;
             }
 
@@ -109,8 +114,8 @@ int IndexPerm::count_full_words(std::string const &pattern, ulong length,
         left_side_value *= m_alphabet->size();
         left_side_value += m_alphabet->get_char_value(pattern[start]);
         start++;
-        right_side_values[0].first %=
-            m_alphabet->pow_wsize(right_side_values[0].second - 1);
+        right_side_values[0].first =
+            m_alphabet->get_divisor(right_side_values[0].second - 1).modulo(right_side_values[0].first);
 
         if (pattern.length() > start + m_word_size)
             right_side_values[0].second--;
@@ -120,17 +125,16 @@ int IndexPerm::count_full_words(std::string const &pattern, ulong length,
     return 0;
 }
 
+template<class t_permutation>
 bool IndexPerm::check_and_extract_value(size_type const position, size_type const array_size,
                                         std::vector<std::pair<size_t, uint> > const &right_side_values) const {
     size_type start = position + m_word_size;
     size_type perm_position = start / m_shift;
-    if (perm_position > m_permutation->get_size())
+    if (perm_position >= m_permutation->get_size())
         perm_position = m_permutation->get_size() - 1;
     size_type word_position = perm_position * m_shift;
 
-    value_type word_value = m_permutation->revpi(perm_position) + 1;
-    auto temp = m_select0->select(word_value);
-    word_value = m_rank1->rank(temp) - 1;
+    value_type word_value = word_value_at<t_permutation>(perm_position);
 
     for (uint i = 0; i < array_size; ++i) {
         auto to = start + right_side_values[i].second;
@@ -139,11 +143,11 @@ bool IndexPerm::check_and_extract_value(size_type const position, size_type cons
             value_type tmp_word_value = word_value;
             size_t word_length = m_word_size;
             if (word_position < start) {
-                tmp_word_value %= m_alphabet->pow_wsize(m_word_size - (start - word_position));
+                tmp_word_value = m_alphabet->get_divisor(m_word_size - (start - word_position)).modulo(tmp_word_value);
                 word_length -= start - word_position;
             }
             if (to < word_position + m_word_size) {
-                tmp_word_value /= m_alphabet->pow_wsize(word_position + m_word_size - to);
+                tmp_word_value = m_alphabet->get_divisor(word_position + m_word_size - to).divide(tmp_word_value);
                 word_length -= word_position + m_word_size - to;
             }
 
@@ -153,13 +157,11 @@ bool IndexPerm::check_and_extract_value(size_type const position, size_type cons
 
             if (start < to) {
                 perm_position = start / m_shift;
-                if (perm_position > m_permutation->get_size())
+                if (perm_position >= m_permutation->get_size())
                     perm_position = m_permutation->get_size() - 1;
                 word_position = perm_position * m_shift;
 
-                word_value = m_permutation->revpi(perm_position) + 1;
-                temp = m_select0->select(word_value);
-                word_value = m_rank1->rank(temp) - 1;
+                word_value = word_value_at<t_permutation>(perm_position);
 
             }
         }
@@ -171,20 +173,20 @@ bool IndexPerm::check_and_extract_value(size_type const position, size_type cons
         start = to;
         if (i < array_size - 1 && word_position + m_word_size <= start) {
             perm_position = start / m_shift;
-            if (perm_position > m_permutation->get_size())
+            if (perm_position >= m_permutation->get_size())
                 perm_position = m_permutation->get_size() - 1;
             word_position = perm_position * m_shift;
 
-            word_value = m_permutation->revpi(perm_position) + 1;
-            temp = m_select0->select(word_value);
-            word_value = m_rank1->rank(temp) - 1;
+            word_value = word_value_at<t_permutation>(perm_position);
         }
     }
 
     return true;
 }
 
-IndexPerm::value_type IndexPerm::extract_value(size_type const from, size_type const length) const{
+template<class t_permutation>
+IndexPerm::value_type IndexPerm::extract_value_kernel(size_type const from,
+                                                      size_type const length) const {
     value_type result = 0;
     size_type to = from + length;
     size_type start = from;
@@ -197,18 +199,16 @@ IndexPerm::value_type IndexPerm::extract_value(size_type const from, size_type c
         }
         size_type word_position = position * m_shift;
 
-        value_type word_value = m_permutation->revpi(position) + 1;
-        auto temp = m_select0->select(word_value);
-        word_value = m_rank1->rank(temp) - 1;
+        value_type word_value = word_value_at<t_permutation>(position);
 
         size_type word_length = m_word_size;
 
         if (word_position < start) {
-            word_value %= m_alphabet->pow_wsize(m_word_size - (start - word_position));
+            word_value = m_alphabet->get_divisor(m_word_size - (start - word_position)).modulo(word_value);
             word_length -= start - word_position;
         }
         if (to < word_position + m_word_size) {
-            word_value /= m_alphabet->pow_wsize(word_position + m_word_size - to);
+            word_value = m_alphabet->get_divisor(word_position + m_word_size - to).divide(word_value);
             word_length -= word_position + m_word_size - to;
         }
 
@@ -220,18 +220,49 @@ IndexPerm::value_type IndexPerm::extract_value(size_type const from, size_type c
     return result;
 }
 
+int IndexPerm::count_full_words(std::string const &pattern, ulong length,
+                                bool const locate, ulong *numocc,
+                                std::vector<ulong> *occ,
+                                Slice const *slice) const {
+    if (m_inverse_sampling > 0)
+        return count_full_words_kernel<SampledRevPermutation>(pattern, length, locate, numocc, occ, slice);
+
+    return count_full_words_kernel<RevPermutation>(pattern, length, locate, numocc, occ, slice);
+}
+
+int IndexPerm::count_short(std::string const &pattern, ulong length,
+                           bool const locate, ulong *numocc,
+                           std::vector<ulong> *occ) const {
+    if (m_inverse_sampling > 0) {
+        return count_short_kernel(pattern, length, [this](size_type from, size_type length) {
+            return extract_value_kernel<SampledRevPermutation>(from, length);
+        }, locate, numocc, occ);
+    }
+
+    return count_short_kernel(pattern, length, [this](size_type from, size_type length) {
+        return extract_value_kernel<RevPermutation>(from, length);
+    }, locate, numocc, occ);
+}
+
+IndexPerm::value_type IndexPerm::extract_value(size_type const from, size_type const length) const {
+    if (m_inverse_sampling > 0)
+        return extract_value_kernel<SampledRevPermutation>(from, length);
+
+    return extract_value_kernel<RevPermutation>(from, length);
+}
+
 std::string IndexPerm::get_word(size_type const start, size_type const length) const {
     ulong position = start / m_shift;
     if (position >= m_permutation->get_size())
         position = m_permutation->get_size() - 1;
 
     size_t word_value = m_permutation->revpi(position) + 1;
-    word_value = m_rank1->rank(m_select0->select(word_value));
+    word_value = m_directory->rank1(m_directory->select0(word_value));
     return m_alphabet->get_word_from_value(word_value - 1, m_word_size).
         substr(start - (position * m_shift), length);
 }
 
-int IndexPerm::extract(ulong const from, ulong const to, std::string *text, ulong *length) const {
+int IndexPerm::extract_text(ulong const from, ulong const to, std::string *text, ulong *length) const {
     ulong _to = std::min(to, m_text_length);
     if (_to < from) {
         *length = 0;
@@ -253,27 +284,21 @@ int IndexPerm::extract(ulong const from, ulong const to, std::string *text, ulon
     return 0;
 }
 
-int IndexPerm::save_index(std::ostream &out) const {
-    out.write((char *) &IndexPerm::INDEX_TYPE, sizeof(uint));
-    Index::save_index(out);
-    m_select0->serialize(out);
-
-    return 0;
+void IndexPerm::save_core(std::ostream &out) const {
+    out.write((char *) &m_inverse_sampling, sizeof(size_type));
+    Index::save_core(out);
 }
 
-void IndexPerm::load(std::istream& in) {
-    uint index_type;
-    in.read((char *) &index_type, sizeof(uint));
-
-     if (index_type != IndexPerm::INDEX_TYPE) {
-        std::cerr << "Wrong index type!\n";
-    }
+void IndexPerm::load_core(std::istream& in) {
+    in.read((char *) &m_inverse_sampling, sizeof(size_type));
+    Index::load_core(in);
+}
 
-    Index::load(in);
-    m_permutation = RevPermutation::load(in);
+Permutation *IndexPerm::load_permutation(std::istream &in) const {
+    if (m_inverse_sampling > 0)
+        return SampledRevPermutation::load(in, m_file_version);
 
-    m_select0 = new sdsl::bit_vector::select_0_type;
-    m_select0->load(in, m_bit_vector);
+    return RevPermutation::load(in, m_file_version);
 }
 
 }
@@ -0,0 +1,85 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+#include "IndexTwoLevel.hpp"
+
+namespace cdat {
+
+uint const IndexTwoLevel::INDEX_TYPE = 4096;
+
+IndexTwoLevel::IndexTwoLevel(size_type word_size, size_type shift,
+                             size_type long_word_size, size_type long_shift) :
+    IndexBitVector(word_size, shift), m_long_index(nullptr),
+    m_long_word_size(long_word_size), m_long_shift(long_shift) {}
+
+IndexTwoLevel::~IndexTwoLevel() {
+    delete m_long_index;
+}
+
+int IndexTwoLevel::count_full_words(std::string const &pattern, ulong length,
+                                    bool const locate, ulong *numocc,
+                                    std::vector<ulong> *occ,
+                                    Slice const *slice) const {
+    if (pattern.length() < m_long_word_size + m_long_shift - 1)
+        return IndexBitVector::count_full_words(pattern, length, locate, numocc, occ, slice);
+
+    if (slice != nullptr && locate)
+        return m_long_index->locate_slice(pattern, *slice, occ, numocc);
+    if (slice != nullptr)
+        return m_long_index->count_slice(pattern, *slice, numocc);
+
+    if (locate)
+        return m_long_index->locate(pattern, length, occ, numocc);
+
+    return m_long_index->count(pattern, length, numocc);
+}
+
+bool IndexTwoLevel::split_query(std::string const &pattern, size_type const max_cells,
+                                std::vector<Slice> *slices) const {
+    if (pattern.length() < m_long_word_size + m_long_shift - 1)
+        return IndexBitVector::split_query(pattern, max_cells, slices);
+
+    load_sections();
+    return m_long_index->split_query(pattern, max_cells, slices);
+}
+
+void IndexTwoLevel::save_core(std::ostream& out) const {
+    out.write((char *) &m_long_word_size, sizeof(size_type));
+    out.write((char *) &m_long_shift, sizeof(size_type));
+    IndexBitVector::save_core(out);
+}
+
+void IndexTwoLevel::load_core(std::istream& in) {
+    in.read((char *) &m_long_word_size, sizeof(size_type));
+    in.read((char *) &m_long_shift, sizeof(size_type));
+    IndexBitVector::load_core(in);
+}
+
+// long level is a whole index file of its own, stored after the shared text
+void IndexTwoLevel::save_text(std::ostream& out) const {
+    IndexBitVector::save_text(out);
+    m_long_index->save_index(out);
+}
+
+void IndexTwoLevel::load_text(std::istream& in) {
+    IndexBitVector::load_text(in);
+
+    m_long_index = new IndexBitVector(0, 0, m_text);
+    m_long_index->load(in);
+    m_long_index->share_boundaries(this);
+}
+
+}
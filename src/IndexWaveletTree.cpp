@@ -14,7 +14,6 @@
     along with this program.  If not, see http://www.gnu.org/licenses/ .
 */
 
-
 #include "IndexWaveletTree.hpp"
 
 namespace cdat {
@@ -22,38 +21,37 @@ namespace cdat {
 uint const IndexWaveletTree::INDEX_TYPE = 512;
 
 IndexWaveletTree::IndexWaveletTree(size_type word_size, size_type shift) :
-    Index(word_size, shift) {}
+    Index(word_size, shift), m_text(nullptr), m_text_type(WaveletText::HUFFMAN) {}
 
 IndexWaveletTree::IndexWaveletTree(size_type word_size, size_type shift, size_type text_length,
-                                   size_type additional_text_length, sdsl::bit_vector *bit_vector,
-                                   sdsl::bit_vector::rank_1_type *rank1,
-                                   sdsl::bit_vector::select_1_type *select1,
-                                   Permutation *permutation, Alphabet *alphabet,
-                                   sdsl::wt_huff<sdsl::bit_vector, sdsl::rank_support_v<>,
-                                   sdsl::select_support_scan<>, sdsl::select_support_scan<> > *text) :
+                                   size_type additional_text_length, BucketDirectory *directory,
+                                   Permutation *permutation, Alphabet *alphabet, WaveletText *text) :
 
     Index(word_size, shift, text_length, additional_text_length,
-          bit_vector, rank1, select1, permutation, alphabet),
-    m_text(text) {}
+          directory, permutation, alphabet),
+    m_text(text), m_text_type(text->get_type()) {}
 
 IndexWaveletTree::~IndexWaveletTree() {
     delete m_text;
 }
 
+template<class t_text>
 bool IndexWaveletTree::check_word(size_type const position, size_type const length, const char *pattern) const {
     for (size_type i = 0; i < length; ++i) {
-        if (pattern[i] != (*m_text)[i + position])
+        if (pattern[i] != text_at<t_text>(i + position))
             return false;
     }
 
     return true;
 }
 
-int IndexWaveletTree::count_full_words(std::string const &pattern, ulong length,
-                                       bool const locate, ulong *numocc,
-                                       std::vector<ulong> *occ) const {
+template<class t_text>
+int IndexWaveletTree::count_full_words_kernel(std::string const &pattern, ulong length,
+                                              bool const locate, ulong *numocc,
+                                              std::vector<ulong> *occ,
+                                              Slice const *slice) const {
     if (pattern.length() == m_word_size) {
-        return count_exact_size_word(pattern, length, numocc, locate, occ);
+        return count_exact_size_word(pattern, length, numocc, locate, occ, slice);
     }
 
     size_type limit = m_shift;
@@ -61,32 +59,30 @@ int IndexWaveletTree::count_full_words(std::string const &pattern, ulong length,
         limit = pattern.length() - m_word_size + 1;
 
     uint start = 0;
+    std::vector<value_type> positions;
     while (start < limit) {
         size_t word_value = m_alphabet->get_word_value(pattern, start,
                                                        start + m_word_size) + 1;
-        size_t position = m_select1->select(word_value);
-        size_t next_position = m_select1->select(word_value + 1) - word_value;
-
-        position = position - word_value + 1;
-        for (ulong i = position; i < next_position; ++i) {
+        decode_scan(word_value - 1, pattern, start, slice, &positions);
+        for (ulong i = 0; i < positions.size(); ++i) {
             size_type right_end = start + m_word_size;
-            size_type curr_word_position = m_permutation->pi(i);
+            size_type curr_word_position = positions[i];
             size_type word_index_position = curr_word_position * m_shift;
 
             if ((word_index_position < start) ||
-                (m_text_length < (word_index_position + m_word_size) +
+                (segment_end(word_index_position - start) < (word_index_position + m_word_size) +
                     (pattern.length() - right_end)))
                 continue;
 
             if (start != 0) {
-                if (!check_word(word_index_position - start, start,
+                if (!check_word<t_text>(word_index_position - start, start,
                                 pattern.c_str())) {
                     continue;
                 }
             }
 
             if (start + m_word_size < pattern.length()) {
-                if (!check_word(word_index_position + m_word_size,
+                if (!check_word<t_text>(word_index_position + m_word_size,
                                 pattern.length() - start - m_word_size,
                                 pattern.c_str() + m_word_size + start)) {
                     continue;
@@ -106,7 +102,9 @@ int IndexWaveletTree::count_full_words(std::string const &pattern, ulong length,
     return 0;
 }
 
-IndexWaveletTree::value_type IndexWaveletTree::extract_value(size_type const from, size_type const length) const{
+template<class t_text>
+IndexWaveletTree::value_type IndexWaveletTree::extract_value_kernel(size_type const from,
+                                                                    size_type const length) const {
     value_type result = 0;
     size_type to = from + length;
     size_type start = from;
@@ -114,15 +112,63 @@ IndexWaveletTree::value_type IndexWaveletTree::extract_value(size_type const fro
     while (start < to) {
         result *= m_alphabet->size();
         if (start < m_text->size())
-            result += m_alphabet->get_char_value((*m_text)[start]);
+            result += m_alphabet->get_char_value(text_at<t_text>(start));
         ++start;
     }
 
     return result;
 }
 
-int IndexWaveletTree::extract(ulong const from, ulong const to,
-                              std::string *text, ulong *length) const {
+template<class t_text>
+int IndexWaveletTree::count_short_text(std::string const &pattern, ulong length,
+                                       bool const locate, ulong *numocc,
+                                       std::vector<ulong> *occ) const {
+    return count_short_kernel(pattern, length, [this](size_type from, size_type length) {
+        return extract_value_kernel<t_text>(from, length);
+    }, locate, numocc, occ);
+}
+
+int IndexWaveletTree::count_short(std::string const &pattern, ulong length,
+                                  bool const locate, ulong *numocc,
+                                  std::vector<ulong> *occ) const {
+    if (m_text_type == WaveletText::MATRIX)
+        return count_short_text<MatrixWaveletText>(pattern, length, locate, numocc, occ);
+    if (m_text_type == WaveletText::INTERLEAVED)
+        return count_short_text<InterleavedWaveletText>(pattern, length, locate, numocc, occ);
+    if (m_text_type == WaveletText::HYBRID)
+        return count_short_text<HybridWaveletText>(pattern, length, locate, numocc, occ);
+
+    return count_short_text<HuffmanWaveletText>(pattern, length, locate, numocc, occ);
+}
+
+int IndexWaveletTree::count_full_words(std::string const &pattern, ulong length,
+                                       bool const locate, ulong *numocc,
+                                       std::vector<ulong> *occ,
+                                       Slice const *slice) const {
+    if (m_text_type == WaveletText::MATRIX)
+        return count_full_words_kernel<MatrixWaveletText>(pattern, length, locate, numocc, occ, slice);
+    if (m_text_type == WaveletText::INTERLEAVED)
+        return count_full_words_kernel<InterleavedWaveletText>(pattern, length, locate, numocc, occ, slice);
+    if (m_text_type == WaveletText::HYBRID)
+        return count_full_words_kernel<HybridWaveletText>(pattern, length, locate, numocc, occ, slice);
+
+    return count_full_words_kernel<HuffmanWaveletText>(pattern, length, locate, numocc, occ, slice);
+}
+
+IndexWaveletTree::value_type IndexWaveletTree::extract_value(size_type const from,
+                                                             size_type const length) const {
+    if (m_text_type == WaveletText::MATRIX)
+        return extract_value_kernel<MatrixWaveletText>(from, length);
+    if (m_text_type == WaveletText::INTERLEAVED)
+        return extract_value_kernel<InterleavedWaveletText>(from, length);
+    if (m_text_type == WaveletText::HYBRID)
+        return extract_value_kernel<HybridWaveletText>(from, length);
+
+    return extract_value_kernel<HuffmanWaveletText>(from, length);
+}
+
+int IndexWaveletTree::extract_text(ulong const from, ulong const to,
+                                   std::string *text, ulong *length) const {
 
     ulong _to = std::min(to, m_text_length);
     if (_to < from) {
@@ -137,7 +183,7 @@ int IndexWaveletTree::extract(ulong const from, ulong const to,
 
     while (current_length < *length) {
         if (from + current_length < m_text->size())
-            *text += (*m_text)[from + current_length];
+            *text += m_text->access(from + current_length);
         else
             *text += m_alphabet->get_char_from_value(0);
         ++current_length;
@@ -146,30 +192,13 @@ int IndexWaveletTree::extract(ulong const from, ulong const to,
     return 0;
 }
 
-int IndexWaveletTree::save_index(std::ostream& out) const {
-    out.write((char *) &IndexWaveletTree::INDEX_TYPE, sizeof(uint));
-    Index::save_index(out);
-    m_text->serialize(out);
-
-    return 0;
+void IndexWaveletTree::save_text(std::ostream& out) const {
+    m_text->save(out);
 }
 
-void IndexWaveletTree::load(std::istream& in) {
-    uint index_type;
-    in.read((char *) &index_type, sizeof(uint));
-
-    if (index_type != INDEX_TYPE) {
-        std::cerr << "Wrong index type!\n";
-    }
-
-    Index::load(in);
-    m_permutation = Permutation::load(in);
-
-    typedef sdsl::wt_huff<sdsl::bit_vector, sdsl::rank_support_v<>,
-                          sdsl::select_support_scan<>, sdsl::select_support_scan<> > wavelet_tree;
-
-    m_text = new wavelet_tree();
-    m_text->load(in);
+void IndexWaveletTree::load_text(std::istream& in) {
+    m_text = WaveletText::load(in);
+    m_text_type = m_text->get_type();
 }
 
 }
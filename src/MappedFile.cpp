@@ -0,0 +1,83 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+
+#include "MappedFile.hpp"
+
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cdat {
+
+MappedFile::~MappedFile() {
+    if (m_data != nullptr)
+        munmap(m_data, m_size);
+}
+
+int MappedFile::open(char const *filename) {
+    int descriptor = ::open(filename, O_RDONLY);
+    if (descriptor < 0) {
+        std::cerr << "Error: unable to open file\n";
+        return -1;
+    }
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+        std::cerr << "Error: unable to read file size\n";
+        close(descriptor);
+        return -1;
+    }
+
+    void *data = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (data == MAP_FAILED) {
+        std::cerr << "Error: unable to map file\n";
+        return -1;
+    }
+
+    m_data = (char *) data;
+    m_size = status.st_size;
+
+    return 0;
+}
+
+MappedBuffer::MappedBuffer(char const *data, size_type const size) {
+    char *begin = const_cast<char *>(data);
+    setg(begin, begin, begin + size);
+}
+
+MappedBuffer::pos_type MappedBuffer::seekoff(off_type offset, std::ios_base::seekdir direction,
+                                             std::ios_base::openmode mode) {
+    char *base = direction == std::ios_base::beg ? eback() :
+        direction == std::ios_base::cur ? gptr() : egptr();
+
+    if (!(mode & std::ios_base::in) || base + offset < eback() || base + offset > egptr())
+        return pos_type(off_type(-1));
+
+    setg(eback(), base + offset, egptr());
+    return pos_type(gptr() - eback());
+}
+
+MappedBuffer::pos_type MappedBuffer::seekpos(pos_type position, std::ios_base::openmode mode) {
+    return seekoff(off_type(position), std::ios_base::beg, mode);
+}
+
+}
@@ -0,0 +1,259 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#include "Mapper.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace cdat {
+
+int Mapper::map(std::string const &read, std::vector<Hit> *hits) const {
+    if (m_index->get_masked_runs() != nullptr) {
+        std::cerr << "Mapping needs an index without masked runs" << std::endl;
+        return -1;
+    }
+
+    std::vector<Anchor> anchors, candidates;
+    collect_anchors(read, &anchors);
+    chain_anchors(anchors, &candidates);
+
+    size_type first = hits->size();
+    size_type best = m_max_distance + 1;
+    for (size_type i = 0; i < candidates.size(); ++i) {
+        Hit hit;
+        if (!extend(read, candidates[i], &hit) || hit.distance > best)
+            continue;
+
+        if (hit.distance < best) {
+            hits->resize(first);
+            best = hit.distance;
+        }
+        hits->push_back(hit);
+    }
+
+    std::sort(hits->begin() + first, hits->end(), [](Hit const &a, Hit const &b) {
+        return a.position < b.position || (a.position == b.position && a.length < b.length);
+    });
+    hits->erase(std::unique(hits->begin() + first, hits->end(), [](Hit const &a, Hit const &b) {
+        return a.position == b.position && a.length == b.length;
+    }), hits->end());
+
+    return 0;
+}
+
+void Mapper::collect_anchors(std::string const &read, std::vector<Anchor> *anchors) const {
+    size_type seed_length = m_index->get_word_size() + m_index->get_shift() - 1;
+    if (read.size() < seed_length)
+        return;
+
+    // error-free run every read within max_distance keeps, a seed fits in it at this stride
+    size_type run = (read.size() - std::min(read.size(), m_max_distance)) / (m_max_distance + 1);
+    size_type stride = run > seed_length ? run - seed_length + 1 : 1;
+
+    std::vector<size_type> offsets;
+    for (size_type offset = 0; offset + seed_length <= read.size(); offset += stride)
+        offsets.push_back(offset);
+    if (offsets.back() + seed_length < read.size())
+        offsets.push_back(read.size() - seed_length);
+
+    // the bucket of the leading word bounds the hits of a seed without a scan, the rarest
+    // seed skipped for its bucket size is taken when no other seed has hits
+    size_type rarest = 0, rarest_count = 0;
+    for (size_type i = 0; i < offsets.size(); ++i) {
+        std::string seed = read.substr(offsets[i], seed_length);
+        ulong count = 0;
+        m_index->count_index(seed, 0, &count);
+        if (count > MAX_SEED_HITS) {
+            if (rarest_count == 0 || count < rarest_count) {
+                rarest = offsets[i];
+                rarest_count = count;
+            }
+            continue;
+        }
+
+        std::vector<ulong> occ;
+        count = 0;
+        m_index->locate(seed, seed.size(), &occ, &count);
+        for (size_type j = 0; j < occ.size(); ++j)
+            anchors->push_back({occ[j], offsets[i]});
+    }
+
+    if (anchors->empty() && rarest_count > 0) {
+        std::string seed = read.substr(rarest, seed_length);
+        std::vector<ulong> occ;
+        ulong count = 0;
+        m_index->locate(seed, seed.size(), &occ, &count);
+        for (size_type j = 0; j < occ.size(); ++j)
+            anchors->push_back({occ[j], rarest});
+    }
+}
+
+/*
+ * Anchors sorted by text position are chained when both the text and the read
+ * advance and their diagonals differ by at most max_distance; a chain scores the
+ * characters its anchors cover. The first anchors of the best chains are returned,
+ * one per diagonal.
+ */
+void Mapper::chain_anchors(std::vector<Anchor> const &anchors, std::vector<Anchor> *candidates) const {
+    if (anchors.empty())
+        return;
+
+    std::vector<Anchor> sorted(anchors);
+    std::sort(sorted.begin(), sorted.end(), [](Anchor const &a, Anchor const &b) {
+        return a.position < b.position || (a.position == b.position && a.offset < b.offset);
+    });
+
+    size_type seed_length = m_index->get_word_size() + m_index->get_shift() - 1;
+    std::vector<size_type> scores(sorted.size()), roots(sorted.size());
+    for (size_type j = 0; j < sorted.size(); ++j) {
+        scores[j] = seed_length;
+        roots[j] = j;
+        size_type limit = j > MAX_PREDECESSORS ? j - MAX_PREDECESSORS : 0;
+        for (size_type i = j; i-- > limit; ) {
+            if (sorted[i].position >= sorted[j].position || sorted[i].offset >= sorted[j].offset)
+                continue;
+
+            size_type text_gap = sorted[j].position - sorted[i].position;
+            size_type read_gap = sorted[j].offset - sorted[i].offset;
+            size_type skew = text_gap > read_gap ? text_gap - read_gap : read_gap - text_gap;
+            if (skew > m_max_distance)
+                continue;
+
+            size_type score = scores[i] + std::min(seed_length, std::min(text_gap, read_gap));
+            if (score > scores[j]) {
+                scores[j] = score;
+                roots[j] = roots[i];
+            }
+        }
+    }
+
+    std::vector<size_type> order(sorted.size());
+    for (size_type j = 0; j < order.size(); ++j)
+        order[j] = j;
+    std::stable_sort(order.begin(), order.end(), [&scores](size_type a, size_type b) {
+        return scores[a] > scores[b];
+    });
+
+    std::vector<size_type> diagonals;
+    for (size_type j = 0; j < order.size() && candidates->size() < MAX_CANDIDATES; ++j) {
+        Anchor const &root = sorted[roots[order[j]]];
+        // wraps around for anchors before the start of the read, only compared for equality
+        size_type diagonal = root.position - root.offset;
+        if (std::find(diagonals.begin(), diagonals.end(), diagonal) != diagonals.end())
+            continue;
+
+        diagonals.push_back(diagonal);
+        candidates->push_back(root);
+    }
+}
+
+/*
+ * The read is aligned to the band of max_distance characters on both sides of the
+ * anchor's diagonal: a semi-global pass finds the first best end, a pass over the
+ * reversed read and band, anchored at that end, finds the start.
+ */
+bool Mapper::extend(std::string const &read, Anchor const &anchor, Hit *hit) const {
+    size_type text_length = m_index->get_text_length();
+    size_type lead = anchor.offset + m_max_distance;
+    size_type from = anchor.position > lead ? anchor.position - lead : 0;
+    size_type to = std::min(text_length, anchor.position + (read.size() - anchor.offset) + m_max_distance);
+    if (to <= from)
+        return false;
+
+    std::string band;
+    ulong length;
+    if (m_index->extract(from, to, &band, &length) < 0)
+        return false;
+
+    size_type end;
+    size_type distance = edit_distance(read, band.data(), band.size(), false, &end);
+    if (distance > m_max_distance)
+        return false;
+
+    std::string reversed_read(read.rbegin(), read.rend());
+    std::string reversed_band(band.rend() - end, band.rend());
+    size_type reversed_end;
+    edit_distance(reversed_read, reversed_band.data(), reversed_band.size(), true, &reversed_end);
+
+    hit->position = from + end - reversed_end;
+    hit->length = reversed_end;
+    hit->distance = distance;
+
+    Records const *records = m_index->get_records();
+    return records == nullptr || !records->crosses(hit->position, hit->length);
+}
+
+/*
+ * Columns of the dynamic programming matrix are kept as vertical deltas, +1 in vp
+ * and -1 in vn, one bit per row split over 64 bit blocks; a block passes the
+ * horizontal delta of its last row to the next one (Myers 1999, Hyyro 2003).
+ */
+Mapper::size_type Mapper::edit_distance(std::string const &pattern, char const *text, size_type const length,
+                                        bool const anchored, size_type *end) {
+    size_type m = pattern.size();
+    *end = 0;
+    if (m == 0)
+        return 0;
+
+    size_type blocks = (m + 63) / 64;
+    std::vector<uint64_t> peq(256 * blocks, 0);
+    for (size_type i = 0; i < m; ++i)
+        peq[(unsigned char) pattern[i] * blocks + i / 64] |= 1ULL << (i % 64);
+
+    std::vector<uint64_t> vp(blocks, ~0ULL), vn(blocks, 0);
+    uint64_t last_bit = 1ULL << ((m - 1) % 64);
+    size_type score = m, best = m;
+    for (size_type j = 0; j < length; ++j) {
+        uint64_t const *eq_column = &peq[(unsigned char) text[j] * blocks];
+        // horizontal delta of row 0: +1 when the substring must start at text[0]
+        int carry = anchored ? 1 : 0;
+        for (size_type b = 0; b < blocks; ++b) {
+            uint64_t eq = eq_column[b];
+            uint64_t p = vp[b], n = vn[b];
+            uint64_t xv = eq | n;
+            if (carry < 0)
+                eq |= 1;
+            uint64_t xh = (((eq & p) + p) ^ p) | eq;
+            uint64_t hp = n | ~(xh | p);
+            uint64_t hn = p & xh;
+
+            uint64_t high = b + 1 == blocks ? last_bit : 1ULL << 63;
+            int out = (hp & high) ? 1 : ((hn & high) ? -1 : 0);
+
+            hp <<= 1;
+            hn <<= 1;
+            if (carry < 0)
+                hn |= 1;
+            else if (carry > 0)
+                hp |= 1;
+            vp[b] = hn | ~(xv | hp);
+            vn[b] = hp & xv;
+            carry = out;
+        }
+
+        score += carry;
+        if (score < best) {
+            best = score;
+            *end = j + 1;
+        }
+    }
+
+    return best;
+}
+
+}
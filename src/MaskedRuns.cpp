@@ -0,0 +1,126 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+
+#include "MaskedRuns.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace cdat {
+
+char const MaskedRuns::MASK_CHAR;
+
+int MaskedRuns::build(char const *filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: unable to open file with masked runs\n";
+        return -1;
+    }
+
+    std::vector<size_type> starts, lengths;
+    size_type start, length;
+    while (file >> start >> length) {
+        if (!starts.empty() && start < starts.back() + lengths.back()) {
+            std::cerr << "Error: masked runs have to be sorted and disjoint\n";
+            return -1;
+        }
+
+        starts.push_back(start);
+        lengths.push_back(length);
+    }
+
+    size_type removed = 0;
+    for (size_type i = 0; i < lengths.size(); ++i)
+        removed += lengths[i];
+
+    // widths of at least one bit, sdsl vectors can't hold zero width values
+    size_type last_start = starts.empty() ? 1 : std::max(starts.back(), (size_type) 1);
+    m_cuts = sdsl::int_vector<>(starts.size(), 0, (uint8_t) cds_utils::bits(last_start));
+    m_removed = sdsl::int_vector<>(starts.size() + 1, 0,
+                                   (uint8_t) cds_utils::bits(std::max(removed, (size_type) 1)));
+
+    removed = 0;
+    for (size_type i = 0; i < starts.size(); ++i) {
+        m_cuts[i] = starts[i] - removed;
+        m_removed[i] = removed;
+        removed += lengths[i];
+    }
+    m_removed[starts.size()] = removed;
+
+    return 0;
+}
+
+MaskedRuns::size_type MaskedRuns::cuts_until(size_type const position) const {
+    size_type begin = 0, end = m_cuts.size();
+
+    while (begin < end) {
+        size_type middle = (begin + end) / 2;
+        if (m_cuts[middle] <= position)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+
+    return begin;
+}
+
+MaskedRuns::size_type MaskedRuns::to_original(size_type const position) const {
+    return position + m_removed[cuts_until(position)];
+}
+
+MaskedRuns::size_type MaskedRuns::to_indexed(size_type const position) const {
+    size_type run = find_run(position);
+    if (run < size() && original_start(run) <= position)
+        return m_cuts[run];
+
+    return position - m_removed[run];
+}
+
+MaskedRuns::size_type MaskedRuns::find_run(size_type const position) const {
+    size_type begin = 0, end = m_cuts.size();
+
+    while (begin < end) {
+        size_type middle = (begin + end) / 2;
+        if (original_end(middle) <= position)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+
+    return begin;
+}
+
+double MaskedRuns::size_in_mega_bytes() const {
+    return sdsl::size_in_mega_bytes(m_cuts) + sdsl::size_in_mega_bytes(m_removed);
+}
+
+void MaskedRuns::save(std::ostream &out) const {
+    m_cuts.serialize(out);
+    m_removed.serialize(out);
+}
+
+MaskedRuns *MaskedRuns::load(std::istream &in) {
+    MaskedRuns *runs = new MaskedRuns();
+    runs->m_cuts.load(in);
+    runs->m_removed.load(in);
+
+    return runs;
+}
+
+}
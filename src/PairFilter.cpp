@@ -0,0 +1,80 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#include "PairFilter.hpp"
+#include "Counter.hpp"
+
+#include <algorithm>
+
+namespace cdat {
+
+int PairFilter::build(std::ifstream &file, size_type const word_size, size_type const shift,
+                      Alphabet const *alphabet, size_type const words_number,
+                      size_type const bits_per_pair) {
+    size_type pairs = words_number > 0 ? words_number - 1 : 0;
+    m_blocks_number = std::max((size_type) 1, (pairs * bits_per_pair + BLOCK_BITS - 1) / BLOCK_BITS);
+    if (m_blocks_number > 0xffffffff)
+        return -1;
+
+    m_bits = PackedArray(m_blocks_number * (BLOCK_BITS / 64), 64);
+
+    file.clear();
+    file.seekg(0, std::ios::beg);
+
+    size_type text_length, additional_text_length;
+    size_type words = 0;
+    value_type previous = 0;
+    // words spanning cuts are kept, their pairs only make the filter pass more patterns
+    scan_words(file, word_size, shift, alphabet, text_length, additional_text_length,
+               std::vector<uint64_t>(), [&](value_type const word_value) {
+                   if (words++ > 0)
+                       add(previous, word_value);
+                   previous = word_value;
+               });
+
+    return 0;
+}
+
+void PairFilter::add(value_type const first, value_type const second) {
+    value_type hash = pair_hash(first, second);
+    size_type block = block_of(hash);
+    value_type bits = mix(hash);
+    for (size_type i = 0; i < HASHES; ++i, bits >>= 9) {
+        size_type bit = bits & (BLOCK_BITS - 1);
+        size_type word = block + (bit >> 6);
+        m_bits.set(word, m_bits.get(word) | (((value_type) 1) << (bit & 63)));
+    }
+}
+
+double PairFilter::size_in_mega_bytes() const {
+    return (m_bits.size_in_bytes() / 1024.0) / 1024.0;
+}
+
+void PairFilter::save(std::ostream &out) const {
+    out.write((char *) &m_blocks_number, sizeof(size_type));
+    m_bits.save(out);
+}
+
+PairFilter *PairFilter::load(std::istream &in, uint const version) {
+    PairFilter *filter = new PairFilter();
+    in.read((char *) &filter->m_blocks_number, sizeof(size_type));
+    filter->m_bits = PackedArray::load(in, filter->m_blocks_number * (BLOCK_BITS / 64), 64, version);
+
+    return filter;
+}
+
+}
@@ -0,0 +1,141 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#include "QGramTable.hpp"
+#include "Counter.hpp"
+
+namespace cdat {
+
+QGramTable::~QGramTable() {
+    for (size_type i = 0; i < m_select1.size(); ++i) {
+        delete m_select1[i];
+        delete m_bit_vectors[i];
+    }
+}
+
+int QGramTable::build(std::ifstream &file, size_type const max_length, Alphabet const *alphabet,
+                      std::vector<size_type> const &boundaries) {
+    m_max_length = max_length;
+    if (max_length == 0)
+        return 0;
+
+    std::vector<value_type> powers(max_length + 1);
+    std::vector<Counter<32> *> counters(max_length);
+    for (size_type q = 0; q <= max_length; ++q) {
+        powers[q] = alphabet->pow_wsize(q);
+    }
+    for (size_type q = 1; q <= max_length; ++q) {
+        counters[q - 1] = new Counter<32>(powers[q]);
+        for (size_type i = 0; i < powers[q]; ++i)
+            counters[q - 1]->set(i, 0);
+    }
+
+    file.clear();
+    file.seekg(0, std::ios::beg);
+
+    value_type word_value = 0;
+    size_type text_length = 0;
+    // characters since the last boundary, words reach no further back
+    size_type segment_length = 0;
+    size_type next_boundary = 0;
+    std::vector<size_type> occurrences(max_length, 0);
+    const size_t BUFFER_SIZE = 16 * 1024;
+    char buffer[BUFFER_SIZE];
+    size_t bytes_read;
+    do {
+        file.read(buffer, BUFFER_SIZE);
+        bytes_read = (size_t) file.gcount();
+
+        for (size_t i = 0; i < bytes_read; ++i) {
+            word_value *= alphabet->size();
+            word_value += alphabet->get_char_value(buffer[i]);
+            word_value = alphabet->get_divisor(max_length).modulo(word_value);
+            while (next_boundary < boundaries.size() && boundaries[next_boundary] == text_length) {
+                segment_length = 0;
+                ++next_boundary;
+            }
+            ++text_length;
+            ++segment_length;
+
+            size_type limit = std::min(segment_length, max_length);
+            for (size_type q = 1; q <= limit; ++q) {
+                counters[q - 1]->inc(alphabet->get_divisor(q).modulo(word_value));
+                ++occurrences[q - 1];
+            }
+        }
+    }
+    while (bytes_read == BUFFER_SIZE);
+
+    for (size_type q = 1; q <= max_length; ++q) {
+        size_type words_number = powers[q];
+
+        sdsl::bit_vector *bit_vector = new sdsl::bit_vector(occurrences[q - 1] + words_number + 1, 0);
+        size_type position = 0;
+        (*bit_vector)[0] = 1;
+
+        for (size_type i = 0; i < words_number - 1; ++i) {
+            position += counters[q - 1]->get(i) + 1;
+            (*bit_vector)[position] = 1;
+        }
+        (*bit_vector)[occurrences[q - 1] + words_number] = 1;
+
+        m_bit_vectors.push_back(bit_vector);
+        m_select1.push_back(new sdsl::bit_vector::select_1_type(bit_vector));
+        delete counters[q - 1];
+    }
+
+    return 0;
+}
+
+double QGramTable::size_in_mega_bytes() const {
+    double result = 0;
+    for (size_type i = 0; i < m_select1.size(); ++i) {
+        result += sdsl::size_in_mega_bytes(*m_bit_vectors[i]);
+        result += sdsl::size_in_mega_bytes(*m_select1[i]);
+    }
+
+    return result;
+}
+
+void QGramTable::save(std::ostream &out) const {
+    out.write((char *) &m_max_length, sizeof(size_type));
+
+    for (size_type i = 0; i < m_max_length; ++i) {
+        m_bit_vectors[i]->serialize(out);
+        m_select1[i]->serialize(out);
+    }
+}
+
+QGramTable *QGramTable::load(std::istream &in) {
+    QGramTable *table = new QGramTable();
+    in.read((char *) &table->m_max_length, sizeof(size_type));
+
+    for (size_type i = 0; i < table->m_max_length; ++i) {
+        sdsl::bit_vector *bit_vector = new sdsl::bit_vector();
+        bit_vector->load(in);
+
+        sdsl::bit_vector::select_1_type *select1 = new sdsl::bit_vector::select_1_type;
+        select1->load(in, bit_vector);
+
+        table->m_bit_vectors.push_back(bit_vector);
+        table->m_select1.push_back(select1);
+    }
+
+    return table;
+}
+
+}
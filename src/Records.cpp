@@ -0,0 +1,99 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#include "Records.hpp"
+
+#include <fstream>
+#include <iostream>
+
+namespace cdat {
+
+Records::~Records() {
+    delete m_starts;
+}
+
+int Records::build(char const *filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: unable to open file with records\n";
+        return -1;
+    }
+
+    std::vector<size_type> starts;
+    size_type start;
+    std::string name;
+    while (file >> start >> name) {
+        if ((starts.empty() && start != 0) || (!starts.empty() && start <= starts.back())) {
+            std::cerr << "Error: records have to start at 0 and be sorted by position\n";
+            return -1;
+        }
+
+        starts.push_back(start);
+        m_names.push_back(name);
+    }
+
+    if (starts.empty()) {
+        std::cerr << "Error: no records in file\n";
+        return -1;
+    }
+
+    sdsl::bit_vector bit_vector(starts.back() + 1, 0);
+    for (size_type i = 0; i < starts.size(); ++i)
+        bit_vector[starts[i]] = 1;
+    m_starts = BucketDirectory::create(BucketDirectory::SPARSE, bit_vector, false);
+
+    return 0;
+}
+
+double Records::size_in_mega_bytes() const {
+    double result = m_starts->size_in_mega_bytes();
+    for (size_type i = 0; i < m_names.size(); ++i)
+        result += m_names[i].size() / 1048576.0;
+
+    return result;
+}
+
+void Records::save(std::ostream &out) const {
+    m_starts->save(out);
+
+    size_type records_number = m_names.size();
+    out.write((char *) &records_number, sizeof(size_type));
+    for (size_type i = 0; i < records_number; ++i) {
+        size_type length = m_names[i].size();
+        out.write((char *) &length, sizeof(size_type));
+        out.write(m_names[i].data(), length);
+    }
+}
+
+Records *Records::load(std::istream &in) {
+    Records *records = new Records();
+    records->m_starts = BucketDirectory::load(in);
+
+    size_type records_number;
+    in.read((char *) &records_number, sizeof(size_type));
+    records->m_names.resize(records_number);
+    for (size_type i = 0; i < records_number; ++i) {
+        size_type length;
+        in.read((char *) &length, sizeof(size_type));
+        records->m_names[i].resize(length);
+        in.read(&records->m_names[i][0], length);
+    }
+
+    return records;
+}
+
+}
@@ -0,0 +1,177 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#include "RepeatBuckets.hpp"
+
+#include <algorithm>
+
+namespace cdat {
+
+int RepeatBuckets::build(std::ifstream &file, BucketDirectory const *directory,
+                         Permutation const *permutation, Alphabet const *alphabet,
+                         size_type const word_size, size_type const shift,
+                         size_type const threshold) {
+    m_threshold = threshold;
+    m_offsets.push_back(0);
+
+    size_type words_number = alphabet->pow_wsize(word_size);
+    for (value_type word_value = 0; word_value < words_number; ++word_value) {
+        size_type begin = directory->select1(word_value + 1) - word_value;
+        size_type end = directory->select1(word_value + 2) - word_value - 1;
+
+        if (end - begin > threshold) {
+            m_words.push_back(word_value);
+            m_offsets.push_back(m_offsets.back() + end - begin);
+        }
+    }
+
+    // text position of the word following every capped position
+    size_type entries = m_offsets.back();
+    std::vector<std::pair<size_type, size_type> > targets(entries);
+    std::vector<value_type> positions(entries), next_words(entries, 0);
+    for (size_type i = 0; i < m_words.size(); ++i) {
+        size_type begin = directory->select1(m_words[i] + 1) - m_words[i];
+        for (size_type j = 0; j < m_offsets[i + 1] - m_offsets[i]; ++j) {
+            positions[m_offsets[i] + j] = permutation->pi(begin + j);
+            targets[m_offsets[i] + j] = std::make_pair(positions[m_offsets[i] + j] * shift + word_size,
+                                                       m_offsets[i] + j);
+        }
+    }
+    std::sort(targets.begin(), targets.end());
+
+    file.clear();
+    file.seekg(0, std::ios::beg);
+
+    Divisor const &words = alphabet->get_divisor(word_size);
+    value_type word_value = 0;
+    size_type char_counter = 0;
+    size_type target = 0;
+    const size_t BUFFER_SIZE = 16 * 1024;
+    char buffer[BUFFER_SIZE];
+    size_t bytes_read;
+    do {
+        file.read(buffer, BUFFER_SIZE);
+        bytes_read = (size_t) file.gcount();
+
+        for (size_t i = 0; i < bytes_read; ++i) {
+            word_value = words.modulo(word_value * alphabet->size() + alphabet->get_char_value(buffer[i]));
+            ++char_counter;
+
+            while (target < entries && targets[target].first + word_size == char_counter) {
+                next_words[targets[target++].second] = word_value;
+            }
+        }
+    }
+    while (bytes_read == BUFFER_SIZE);
+
+    // words running past the end of the text are padded like the last word of the index
+    for (size_type i = 0; i < 2 * word_size && target < entries; ++i) {
+        word_value = words.modulo(word_value * alphabet->size());
+        ++char_counter;
+
+        while (target < entries && targets[target].first + word_size == char_counter) {
+            next_words[targets[target++].second] = word_value;
+        }
+    }
+
+    std::vector<size_type> order(entries);
+    for (size_type i = 0; i < entries; ++i) {
+        order[i] = i;
+    }
+    for (size_type i = 0; i < m_words.size(); ++i) {
+        std::stable_sort(order.begin() + m_offsets[i], order.begin() + m_offsets[i + 1],
+                         [&next_words](size_type a, size_type b) {
+                             return next_words[a] < next_words[b];
+                         });
+    }
+
+    m_next_words = sdsl::int_vector<>(entries, 0, (uint8_t) cds_utils::bits(words_number - 1));
+    m_positions = sdsl::int_vector<>(entries, 0, (uint8_t) permutation->get_cell_size());
+    for (size_type i = 0; i < entries; ++i) {
+        m_next_words[i] = next_words[order[i]];
+        m_positions[i] = positions[order[i]];
+    }
+
+    return 0;
+}
+
+bool RepeatBuckets::find(value_type const word_value, size_type *bucket) const {
+    auto it = std::lower_bound(m_words.begin(), m_words.end(), word_value);
+    if (it == m_words.end() || *it != word_value)
+        return false;
+
+    *bucket = it - m_words.begin();
+    return true;
+}
+
+void RepeatBuckets::decode_range(size_type const bucket, value_type const lower,
+                                 value_type const upper, std::vector<value_type> *positions) const {
+    size_type begin = m_offsets[bucket], end = m_offsets[bucket + 1];
+
+    size_type low = begin, high = end;
+    while (low < high) {
+        size_type middle = low + (high - low) / 2;
+        if (m_next_words[middle] < lower)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    positions->clear();
+    for (size_type i = low; i < end && m_next_words[i] < upper; ++i) {
+        positions->push_back(m_positions[i]);
+    }
+}
+
+double RepeatBuckets::size_in_mega_bytes() const {
+    double result = sdsl::size_in_mega_bytes(m_next_words);
+    result += sdsl::size_in_mega_bytes(m_positions);
+    result += ((sizeof(value_type) * m_words.size() + sizeof(size_type) * m_offsets.size()) / 1024.0) / 1024.0;
+
+    return result;
+}
+
+void RepeatBuckets::save(std::ostream &out) const {
+    out.write((char *) &m_threshold, sizeof(size_type));
+
+    size_type words = m_words.size();
+    out.write((char *) &words, sizeof(size_type));
+    out.write((char *) m_words.data(), words * sizeof(value_type));
+    out.write((char *) m_offsets.data(), (words + 1) * sizeof(size_type));
+
+    m_next_words.serialize(out);
+    m_positions.serialize(out);
+}
+
+RepeatBuckets *RepeatBuckets::load(std::istream &in) {
+    RepeatBuckets *buckets = new RepeatBuckets();
+    in.read((char *) &buckets->m_threshold, sizeof(size_type));
+
+    size_type words;
+    in.read((char *) &words, sizeof(size_type));
+    buckets->m_words.resize(words);
+    buckets->m_offsets.resize(words + 1);
+    in.read((char *) buckets->m_words.data(), words * sizeof(value_type));
+    in.read((char *) buckets->m_offsets.data(), (words + 1) * sizeof(size_type));
+
+    buckets->m_next_words.load(in);
+    buckets->m_positions.load(in);
+
+    return buckets;
+}
+
+}
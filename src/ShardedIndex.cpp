@@ -0,0 +1,192 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#include "ShardedIndex.hpp"
+
+#include <algorithm>
+
+namespace cdat {
+
+ShardedIndex::~ShardedIndex() {
+    for (size_type i = 0; i < m_shards.size(); ++i)
+        delete m_shards[i].index;
+}
+
+ShardedIndex *ShardedIndex::load_manifest(char const *filename) {
+    std::ifstream file(filename);
+    std::string keyword;
+    ShardedIndex *result = new ShardedIndex();
+
+    if (!(file >> keyword >> result->m_overlap) || keyword != "overlap") {
+        delete result;
+        std::cerr << "Couldn't load shards from file, wrong format.";
+        throw std::runtime_error("Wrong file.");
+    }
+
+    std::string path = filename;
+    std::string directory = path.substr(0, path.find_last_of('/') + 1);
+    std::string shard_file;
+    Shard shard;
+    while (file >> shard_file >> shard.offset >> shard.length) {
+        if (shard_file[0] != '/')
+            shard_file = directory + shard_file;
+
+        try {
+            shard.index = Index::map_index(shard_file.c_str());
+            shard.overlap = get_overlap(shard.index, shard.length);
+        }
+        catch (...) {
+            delete result;
+            throw;
+        }
+        result->m_shards.push_back(shard);
+    }
+
+    return result;
+}
+
+double ShardedIndex::get_size_in_mega_bytes() const {
+    double result = 0;
+    for (size_type i = 0; i < m_shards.size(); ++i)
+        result += m_shards[i].index->get_size_in_mega_bytes();
+
+    return result;
+}
+
+bool ShardedIndex::validate(std::string const &pattern) const {
+    if (pattern.length() <= m_overlap + 1)
+        return true;
+
+    std::cerr << "Pattern longer than shard overlap + 1.\n";
+    return false;
+}
+
+// read once when the shard is loaded, so queries don't extract it again
+std::string ShardedIndex::get_overlap(Index const *index, size_type const length) {
+    size_type text_length = index->get_text_length();
+    if (length >= text_length)
+        return std::string();
+
+    std::string overlap;
+    ulong overlap_length;
+    index->extract(length, text_length, &overlap, &overlap_length);
+    return overlap;
+}
+
+ulong ShardedIndex::count_overlap(std::string const &overlap, std::string const &pattern) {
+    ulong result = 0;
+    for (size_type i = overlap.find(pattern); i != std::string::npos; i = overlap.find(pattern, i + 1))
+        ++result;
+
+    return result;
+}
+
+// positions in the owned range are appended as text offsets, returns their number
+ulong ShardedIndex::add_owned(Shard const &shard, std::vector<ulong> const &occ, std::vector<ulong> *result) {
+    ulong owned = 0;
+    for (size_type j = 0; j < occ.size(); ++j) {
+        if (occ[j] < shard.length) {
+            result->push_back(occ[j] + shard.offset);
+            ++owned;
+        }
+    }
+
+    return owned;
+}
+
+int ShardedIndex::count(std::string const &pattern, ulong const length, ulong *numocc) const {
+    if (!validate(pattern))
+        return -1;
+
+    *numocc = 0;
+    int result = 0;
+    for (size_type i = 0; i < m_shards.size(); ++i) {
+        ulong count = 0;
+        result = std::min(result, m_shards[i].index->count(pattern, length, &count));
+        *numocc += count - count_overlap(m_shards[i].overlap, pattern);
+    }
+
+    return result;
+}
+
+int ShardedIndex::locate(std::string const &pattern, ulong const length, std::vector<ulong> *occ,
+                         ulong *numocc) const {
+    if (!validate(pattern))
+        return -1;
+
+    *numocc = 0;
+    int result = 0;
+    std::vector<ulong> occurrences;
+    for (size_type i = 0; i < m_shards.size(); ++i) {
+        ulong count = 0;
+        occurrences.clear();
+        result = std::min(result, m_shards[i].index->locate(pattern, length, &occurrences, &count));
+        *numocc += add_owned(m_shards[i], occurrences, occ);
+    }
+
+    return result;
+}
+
+// shards are answered one after another, each as a whole batch so the workers of the
+// scheduler stay busy with groups of patterns instead of waiting for single queries
+void ShardedIndex::count_batch(std::vector<std::string> const &patterns, TaskScheduler *scheduler,
+                               std::vector<ulong> *numocc) const {
+    numocc->assign(patterns.size(), 0);
+    std::vector<ulong> counts;
+    for (size_type i = 0; i < m_shards.size(); ++i) {
+        Index const *index = m_shards[i].index;
+        if (scheduler != nullptr)
+            index->count_parallel(patterns, scheduler, &counts);
+        else
+            index->count_batch(patterns, &counts);
+
+        for (size_type j = 0; j < patterns.size(); ++j)
+            (*numocc)[j] += counts[j] - count_overlap(m_shards[i].overlap, patterns[j]);
+    }
+
+    for (size_type j = 0; j < patterns.size(); ++j) {
+        if (!validate(patterns[j]))
+            (*numocc)[j] = 0;
+    }
+}
+
+void ShardedIndex::locate_batch(std::vector<std::string> const &patterns, TaskScheduler *scheduler,
+                                std::vector<std::vector<ulong> > *occ, std::vector<ulong> *numocc) const {
+    numocc->assign(patterns.size(), 0);
+    occ->assign(patterns.size(), std::vector<ulong>());
+    std::vector<std::vector<ulong> > occurrences;
+    std::vector<ulong> counts;
+    for (size_type i = 0; i < m_shards.size(); ++i) {
+        Index const *index = m_shards[i].index;
+        if (scheduler != nullptr)
+            index->locate_parallel(patterns, scheduler, &occurrences, &counts);
+        else
+            index->locate_batch(patterns, &occurrences, &counts);
+
+        for (size_type j = 0; j < patterns.size(); ++j)
+            (*numocc)[j] += add_owned(m_shards[i], occurrences[j], &(*occ)[j]);
+    }
+
+    for (size_type j = 0; j < patterns.size(); ++j) {
+        if (!validate(patterns[j])) {
+            (*numocc)[j] = 0;
+            (*occ)[j].clear();
+        }
+    }
+}
+
+}
@@ -0,0 +1,93 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#include "SuffixDirectory.hpp"
+
+namespace cdat {
+
+SuffixDirectory::~SuffixDirectory() {
+    delete m_permutation;
+    delete m_select1;
+    delete m_bit_vector;
+}
+
+void SuffixDirectory::build(BucketDirectory const *directory,
+                            Permutation const *permutation,
+                            Alphabet const *alphabet, size_type const word_size) {
+    size_type words_number = alphabet->pow_wsize(word_size);
+    size_type genome_words_number = permutation->get_size();
+
+    m_bit_vector = new sdsl::bit_vector(genome_words_number + words_number + 1, 0);
+    m_permutation = new Permutation(genome_words_number, permutation->get_cell_size());
+    (*m_bit_vector)[0] = 1;
+
+    size_type position = 0;
+    size_type perm_position = 0;
+    Divisor const &by_size = alphabet->get_divisor(1);
+    for (value_type reversed_value = 0; reversed_value < words_number; ++reversed_value) {
+        value_type word_value = 0;
+        value_type rest = reversed_value;
+        for (size_type i = 0; i < word_size; ++i) {
+            value_type quotient = by_size.divide(rest);
+            word_value *= alphabet->size();
+            word_value += rest - quotient * alphabet->size();
+            rest = quotient;
+        }
+
+        // buckets of the main directory keep positions in text order, copy them as they are
+        size_type begin = directory->select1(word_value + 1) - word_value;
+        size_type end = directory->select1(word_value + 2) - word_value - 1;
+        for (size_type i = begin; i < end; ++i) {
+            m_permutation->set_field(perm_position++, permutation->pi(i));
+        }
+
+        position += end - begin + 1;
+        (*m_bit_vector)[position] = 1;
+    }
+
+    m_select1 = new sdsl::bit_vector::select_1_type(m_bit_vector);
+}
+
+double SuffixDirectory::size_in_mega_bytes() const {
+    double result = sdsl::size_in_mega_bytes(*m_bit_vector);
+    result += sdsl::size_in_mega_bytes(*m_select1);
+    result += m_permutation->size_in_mega_bytes();
+
+    return result;
+}
+
+void SuffixDirectory::save(std::ostream &out) const {
+    m_bit_vector->serialize(out);
+    m_select1->serialize(out);
+    m_permutation->save(out);
+}
+
+SuffixDirectory *SuffixDirectory::load(std::istream &in, uint const version) {
+    SuffixDirectory *directory = new SuffixDirectory();
+
+    directory->m_bit_vector = new sdsl::bit_vector();
+    directory->m_bit_vector->load(in);
+
+    directory->m_select1 = new sdsl::bit_vector::select_1_type;
+    directory->m_select1->load(in, directory->m_bit_vector);
+
+    directory->m_permutation = Permutation::load(in, version);
+
+    return directory;
+}
+
+}
@@ -0,0 +1,126 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#include "TaskScheduler.hpp"
+
+#include <algorithm>
+
+namespace cdat {
+
+namespace {
+
+// queue of the worker running on this thread, spawn from other threads picks one in turn
+thread_local TaskScheduler const *current_scheduler = nullptr;
+thread_local TaskScheduler::size_type current_worker = 0;
+
+}
+
+TaskScheduler::TaskScheduler(size_type workers) : m_queued(0), m_pending(0), m_next_queue(0), m_stop(false) {
+    if (workers == 0)
+        workers = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_type i = 0; i < workers; ++i)
+        m_queues.emplace_back(new Queue());
+    for (size_type i = 0; i < workers; ++i)
+        m_threads.emplace_back(&TaskScheduler::work, this, i);
+}
+
+TaskScheduler::~TaskScheduler() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wakeup.notify_all();
+
+    for (size_type i = 0; i < m_threads.size(); ++i)
+        m_threads[i].join();
+}
+
+void TaskScheduler::spawn(Task task) {
+    size_type queue = current_scheduler == this ? current_worker : m_next_queue++ % m_queues.size();
+
+    ++m_pending;
+    {
+        std::lock_guard<std::mutex> lock(m_queues[queue]->mutex);
+        m_queues[queue]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_queued;
+    }
+    m_wakeup.notify_one();
+}
+
+void TaskScheduler::wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_pending == 0; });
+}
+
+bool TaskScheduler::pop(size_type const worker, Task *task) {
+    Queue &queue = *m_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+        return false;
+
+    *task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+// oldest tasks are the coarsest ones, a thief takes them from the front
+bool TaskScheduler::steal(size_type const worker, Task *task) {
+    for (size_type i = 1; i < m_queues.size(); ++i) {
+        Queue &queue = *m_queues[(worker + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+
+        *task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    return false;
+}
+
+void TaskScheduler::work(size_type const worker) {
+    current_scheduler = this;
+    current_worker = worker;
+
+    Task task;
+    while (true) {
+        if (pop(worker, &task) || steal(worker, &task)) {
+            --m_queued;
+            task();
+            task = nullptr;
+
+            if (--m_pending == 0) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_done.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wakeup.wait(lock, [this]() { return m_stop || m_queued > 0; });
+        if (m_stop && m_queued <= 0)
+            return;
+    }
+}
+
+}
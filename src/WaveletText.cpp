@@ -0,0 +1,81 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#include "WaveletText.hpp"
+
+namespace cdat {
+
+uint const WaveletText::HUFFMAN;
+uint const WaveletText::MATRIX;
+uint const WaveletText::INTERLEAVED;
+uint const WaveletText::HYBRID;
+
+WaveletText *WaveletText::create(uint const type, char const *filename) {
+    if (type == MATRIX)
+        return new MatrixWaveletText(filename);
+    if (type == INTERLEAVED)
+        return new InterleavedWaveletText(filename);
+    if (type == HYBRID)
+        return new HybridWaveletText(filename);
+
+    return new HuffmanWaveletText(filename);
+}
+
+WaveletText *WaveletText::load(std::istream &in) {
+    uint type;
+    in.read((char *) &type, sizeof(uint));
+
+    if (type == HUFFMAN)
+        return HuffmanWaveletText::load(in);
+    if (type == MATRIX)
+        return MatrixWaveletText::load(in);
+    if (type == INTERLEAVED)
+        return InterleavedWaveletText::load(in);
+    if (type == HYBRID)
+        return HybridWaveletText::load(in);
+
+    std::cerr << "Wrong wavelet text type!\n";
+    throw std::runtime_error("Wrong wavelet text type");
+}
+
+bool WaveletText::parse_type(std::string const &name, uint *type) {
+    if (name == "huff")
+        *type = HUFFMAN;
+    else if (name == "matrix")
+        *type = MATRIX;
+    else if (name == "il")
+        *type = INTERLEAVED;
+    else if (name == "hyb")
+        *type = HYBRID;
+    else
+        return false;
+
+    return true;
+}
+
+std::string WaveletText::get_type_name(uint const type) {
+    if (type == MATRIX)
+        return "matrix";
+    if (type == INTERLEAVED)
+        return "il";
+    if (type == HYBRID)
+        return "hyb";
+
+    return "huff";
+}
+
+}
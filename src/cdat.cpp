@@ -16,6 +16,10 @@
 
 
 #include "Index.hpp"
+#include "IndexTwoLevel.hpp"
+#include "IndexWaveletTree.hpp"
+#include "Mapper.hpp"
+#include "ShardedIndex.hpp"
 
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/parsers.hpp>
@@ -26,21 +30,20 @@ namespace po = boost::program_options;
 
 
 Index * load_from_file(std::string const &file_name) {
-    std::filebuf fb;
-    fb.open (file_name, std::ios::in);
-    std::istream in(&fb);
-
-    Index *index = Index::load_index(in);
-    fb.close();
-
-    return index;
+    return Index::map_index(file_name.c_str());
 }
 
-void print_locate(std::string const &pattern, std::vector<ulong> const &occ, std::ostream &out) {
-    out << "\'" <<pattern << "\' occurrences are:\n" << "[";
+void print_positions(std::vector<ulong> const &occ, Records const *records, std::ostream &out) {
+    out << "[";
 
     for (size_t i = 0; i < occ.size(); ++i) {
-        out << occ[i];
+        if (records != nullptr) {
+            Records::size_type record = records->find_record(occ[i]);
+            out << records->get_name(record) << ":" << occ[i] - records->get_start(record);
+        }
+        else {
+            out << occ[i];
+        }
 
         if (i < occ.size() - 1) {
             out << ", ";
@@ -50,60 +53,317 @@ void print_locate(std::string const &pattern, std::vector<ulong> const &occ, std
     out << "]\n";
 }
 
-void locate(Index * index, std::string &filename, std::ostream &out) {
-    timeval start, stop, t2;
-    unsigned long time = 0;
+void print_locate(std::string const &pattern, std::vector<ulong> const &occ, Records const *records,
+                  std::ostream &out) {
+    out << "\'" <<pattern << "\' occurrences are:\n";
+    print_positions(occ, records, out);
+}
+
+// positions of sharded indexes are printed as text offsets
+Records const *get_records(Index const *index) {
+    return index->get_records();
+}
+
+Records const *get_records(ShardedIndex const *) {
+    return nullptr;
+}
+
+// patterns read at once by batch queries
+size_t const BATCH_SIZE = 1 << 12;
+
+// batches are answered on the scheduler when there is one
+void count_batch(Index const *index, std::vector<std::string> const &patterns, TaskScheduler *scheduler,
+                 std::vector<ulong> *counts) {
+    if (scheduler != nullptr)
+        index->count_parallel(patterns, scheduler, counts);
+    else
+        index->count_batch(patterns, counts);
+}
+
+void count_batch(ShardedIndex const *index, std::vector<std::string> const &patterns, TaskScheduler *scheduler,
+                 std::vector<ulong> *counts) {
+    index->count_batch(patterns, scheduler, counts);
+}
+
+void locate_batch(Index const *index, std::vector<std::string> const &patterns, TaskScheduler *scheduler,
+                  std::vector<std::vector<ulong> > *occurrences, std::vector<ulong> *counts) {
+    if (scheduler != nullptr)
+        index->locate_parallel(patterns, scheduler, occurrences, counts);
+    else
+        index->locate_batch(patterns, occurrences, counts);
+}
+
+void locate_batch(ShardedIndex const *index, std::vector<std::string> const &patterns, TaskScheduler *scheduler,
+                  std::vector<std::vector<ulong> > *occurrences, std::vector<ulong> *counts) {
+    index->locate_batch(patterns, scheduler, occurrences, counts);
+}
+
+bool read_patterns(std::ifstream &file, std::vector<std::string> *patterns) {
+    patterns->clear();
+    std::string line;
+    while (patterns->size() < BATCH_SIZE && getline(file, line))
+        patterns->push_back(line);
+
+    return !patterns->empty();
+}
+
+void print_time(char const *msg, ulong const occurrences, ulong const queries, timeval const &start) {
+    timeval stop, t2;
+    gettimeofday(&stop, NULL);
+    timersub(&stop, &start, &t2);
+    unsigned long time = (t2.tv_sec) * 1000 + (t2.tv_usec) / 1000;
+
+    std::cout << msg << occurrences << " occurrences of patterns in " << time / 1000.0 << "[s], "
+        << (ulong) (queries / std::max(time / 1000.0, 0.001)) << " queries/s.\n";
+}
 
+template<typename t_index>
+void locate(t_index const *index, std::string &filename, bool const batch, TaskScheduler *scheduler,
+            std::ostream &out) {
+    timeval start;
     gettimeofday(&start, NULL);
     std::ifstream file(filename);
     std::string line;
     ulong count_global = 0;
+    ulong queries = 0;
+
+    if (batch) {
+        std::vector<std::string> patterns;
+        std::vector<std::vector<ulong> > occurrences;
+        std::vector<ulong> counts;
+        while (read_patterns(file, &patterns)) {
+            locate_batch(index, patterns, scheduler, &occurrences, &counts);
+            for (size_t i = 0; i < patterns.size(); ++i) {
+                print_locate(patterns[i], occurrences[i], get_records(index), out);
+                count_global += counts[i];
+            }
+            queries += patterns.size();
+        }
+    }
 
-    while (getline(file, line)) {
+    while (!batch && getline(file, line)) {
         ulong count = 0;
         std::vector<ulong> occurrences;
         occurrences.reserve(1 << 10);
 
         index->locate(line, line.size(), &occurrences, &count);
-        print_locate(line, occurrences, out);
+        print_locate(line, occurrences, get_records(index), out);
 
         count_global += count;
-
+        ++queries;
     }
 
     file.close();
-
-    gettimeofday(&stop, NULL);
-    timersub(&stop, &start, &t2);
-    time += (t2.tv_sec) * 1000 + (t2.tv_usec) / 1000;
-
-    std::cout << "Located " << count_global << " occurrences of patterns in " << time / 1000.0 << "[s].\n";
+    print_time("Located ", count_global, queries, start);
 }
 
-void count(Index * index, std::string &filename, std::ostream &out) {
-    timeval start, stop, t2;
-    unsigned long time = 0;
-
+template<typename t_index>
+void count(t_index const *index, std::string &filename, bool const batch, TaskScheduler *scheduler,
+           std::ostream &out) {
+    timeval start;
     gettimeofday(&start, NULL);
     std::ifstream file(filename);
     std::string line;
     ulong global_count = 0;
+    ulong queries = 0;
+
+    if (batch) {
+        std::vector<std::string> patterns;
+        std::vector<ulong> counts;
+        while (read_patterns(file, &patterns)) {
+            count_batch(index, patterns, scheduler, &counts);
+            for (size_t i = 0; i < patterns.size(); ++i) {
+                out << "\'" << patterns[i] << "\' number of occurrences = " << counts[i] << "\n";
+                global_count += counts[i];
+            }
+            queries += patterns.size();
+        }
+    }
 
-    while (getline(file, line)) {
+    while (!batch && getline(file, line)) {
         ulong count = 0;
         index->count(line, line.size(), &count);
         out << "\'" << line << "\' number of occurrences = " << count << "\n";
 
         global_count += count;
+        ++queries;
     }
 
     file.close();
+    print_time("Found ", global_count, queries, start);
+}
+
+void print_hits(std::string const &read, std::vector<Mapper::Hit> const &hits, ulong const max_distance,
+                Records const *records, std::ostream &out) {
+    if (hits.empty()) {
+        out << "\'" << read << "\' has no hits within edit distance " << max_distance << "\n";
+        return;
+    }
+
+    std::vector<ulong> positions;
+    for (size_t i = 0; i < hits.size(); ++i)
+        positions.push_back(hits[i].position);
+
+    out << "\'" << read << "\' best hits with edit distance " << hits[0].distance << " are:\n";
+    print_positions(positions, records, out);
+}
+
+// reads of a batch are mapped in groups on the scheduler when there is one
+void map(Index const *index, std::string &filename, ulong const max_distance, TaskScheduler *scheduler,
+         std::ostream &out) {
+    if (index->get_masked_runs() != nullptr) {
+        std::cerr << "Reads can't be mapped on indexes with masked runs.\n";
+        return;
+    }
+
+    timeval start;
+    gettimeofday(&start, NULL);
+    std::ifstream file(filename);
+    Mapper mapper(index, max_distance);
+    ulong hits_global = 0;
+    ulong queries = 0;
+
+    size_t const GROUP_SIZE = 64;
+    index->load_sections();
+    std::vector<std::string> reads;
+    while (read_patterns(file, &reads)) {
+        std::vector<std::vector<Mapper::Hit> > hits(reads.size());
+        for (size_t first = 0; first < reads.size(); first += GROUP_SIZE) {
+            size_t last = std::min(reads.size(), first + GROUP_SIZE);
+            auto run = [&, first, last]() {
+                for (size_t i = first; i < last; ++i)
+                    mapper.map(reads[i], &hits[i]);
+            };
+
+            if (scheduler != nullptr)
+                scheduler->spawn(run);
+            else
+                run();
+        }
+        if (scheduler != nullptr)
+            scheduler->wait();
+
+        for (size_t i = 0; i < reads.size(); ++i) {
+            print_hits(reads[i], hits[i], max_distance, index->get_records(), out);
+            hits_global += hits[i].size();
+        }
+        queries += reads.size();
+    }
+
+    print_time("Mapped ", hits_global, queries, start);
+}
+
+void run_mapping(Index const *index, ulong const max_distance, TaskScheduler *scheduler,
+                 std::string &pattern_file, bool const save_file, std::string const &output_file) {
+    if (save_file) {
+        std::filebuf fb;
+        fb.open(output_file, std::ios::out);
+        std::ostream out(&fb);
+        map(index, pattern_file, max_distance, scheduler, out);
+        fb.close();
+    }
+    else {
+        map(index, pattern_file, max_distance, scheduler, std::cout);
+    }
+}
+
+void print_directory(Index const *index) {
+    BucketDirectory const *directory = index->get_directory();
+    BucketDirectory::size_type ones = directory->rank1(directory->size());
+    BucketDirectory::size_type queries = 1 << 20;
+    BucketDirectory::size_type checksum = 0;
+
+    timeval start, stop, t2;
+    gettimeofday(&start, NULL);
+
+    // multiplicative hashing spreads queries over the whole directory
+    for (BucketDirectory::size_type i = 0; i < queries; ++i) {
+        checksum += directory->select1(((i * 2654435761ULL) % ones) + 1);
+    }
+
+    gettimeofday(&stop, NULL);
+    timersub(&stop, &start, &t2);
+    double time = (t2.tv_sec) * 1000000.0 + t2.tv_usec;
+
+    std::cout << "Directory " << BucketDirectory::get_type_name(directory->get_type()) << " takes "
+        << directory->size_in_mega_bytes() << "[mb], select takes "
+        << (time * 1000.0) / queries << "[ns] (checksum " << checksum << ").\n";
+}
+
+void print_text(Index const *index) {
+    IndexWaveletTree const *wt_index = dynamic_cast<IndexWaveletTree const *>(index);
+    if (wt_index == nullptr)
+        return;
+
+    // the text section is otherwise read by the first query that needs it
+    index->load_sections();
+    WaveletText const *text = wt_index->get_text();
+    WaveletText::size_type queries = std::min((WaveletText::size_type) 1 << 20, text->size());
+    WaveletText::size_type checksum = 0;
+
+    timeval start, stop, t2;
+    gettimeofday(&start, NULL);
+
+    for (WaveletText::size_type i = 0; i < queries; ++i) {
+        checksum += text->access((i * 2654435761ULL) % text->size());
+    }
+
+    gettimeofday(&stop, NULL);
+    timersub(&stop, &start, &t2);
+    double access_time = (t2.tv_sec) * 1000000.0 + t2.tv_usec;
+
+    gettimeofday(&start, NULL);
+
+    for (WaveletText::size_type i = 0; i < queries; ++i) {
+        checksum += text->access(i);
+    }
 
     gettimeofday(&stop, NULL);
     timersub(&stop, &start, &t2);
-    time += (t2.tv_sec) * 1000 + (t2.tv_usec) / 1000;
+    double decode_time = (t2.tv_sec) * 1000000.0 + t2.tv_usec;
+
+    std::cout << "Text " << WaveletText::get_type_name(text->get_type()) << " takes "
+        << text->size_in_mega_bytes() << "[mb], access takes " << (access_time * 1000.0) / queries
+        << "[ns], range decode takes " << (decode_time * 1000.0) / queries
+        << "[ns] per character (checksum " << checksum << ").\n";
+}
+
+void print_levels(Index const *index) {
+    IndexTwoLevel const *two_level_index = dynamic_cast<IndexTwoLevel const *>(index);
+    if (two_level_index == nullptr)
+        return;
+
+    std::cout << "Short level of size " << index->get_word_size() << " and shift " << index->get_shift()
+        << " takes " << two_level_index->get_short_size_in_mega_bytes() << "[mb] with text, long level of size "
+        << two_level_index->get_long_word_size() << " and shift " << two_level_index->get_long_shift() << " takes "
+        << two_level_index->get_long_size_in_mega_bytes() << "[mb].\n";
+}
+
+template<typename t_index>
+void run_queries(t_index const *index, bool const is_locate, bool const batch, TaskScheduler *scheduler,
+                 std::string &pattern_file, bool const save_file, std::string const &output_file) {
+    if (save_file) {
+        std::filebuf fb;
+        fb.open(output_file, std::ios::out);
+        std::ostream out(&fb);
+
+        if (is_locate) {
+            locate(index, pattern_file, batch, scheduler, out);
+        }
+        else {
+            count(index, pattern_file, batch, scheduler, out);
+        }
 
-    std::cout << "Found " << global_count << " occurrences of pattern in " << time / 1000.0 << "[s].\n";
+        fb.close();
+    }
+    else {
+        if (is_locate) {
+            locate(index, pattern_file, batch, scheduler, std::cout);
+        }
+        else {
+            count(index, pattern_file, batch, scheduler, std::cout);
+        }
+    }
 }
 
 int main(int argc, char *argv[]) {
@@ -111,7 +371,13 @@ int main(int argc, char *argv[]) {
     std::string pattern_file;
     std::string output_file;
     bool isLocate = false;
+    bool isMap = false;
     bool save_file = false;
+    bool sharded = false;
+    bool batch = false;
+    bool stats = false;
+    int threads = 1;
+    int errors = 4;
 
     try {
         po::options_description desc("Allowed options");
@@ -120,7 +386,12 @@ int main(int argc, char *argv[]) {
             ("index,i", po::value<std::string>(&input_file)->required(), "input file with index")
             ("pattern,p", po::value<std::string>(&pattern_file)->required(), "file with patterns to search")
             ("out,o", po::value<std::string>(&output_file), "file to write results, if not specified results will be displayed to stdout.")
-            ("action,a", po::value<std::string>(&pattern_file)->required(), "locate or count")
+            ("action,a", po::value<std::string>(&pattern_file)->required(), "locate, count or map")
+            ("sharded,s", "input file is a manifest of shards written by split_text, patterns run on the shards one after another unless -j spreads batches over threads")
+            ("batch,b", po::bool_switch(&batch), "answer patterns in interleaved groups, prefetching each lookup step of a group before reading it")
+            ("threads,j", po::value<int>(&threads)->default_value(1), "number of query threads, 0 uses all hardware threads, more than one answers patterns in batches on a work-stealing scheduler")
+            ("errors,e", po::value<int>(&errors)->default_value(4), "maximal edit distance of hits reported by map")
+            ("stats,t", po::bool_switch(&stats), "measure select latency of the bucket directory and access speed of wavelet texts after loading, which reads the text section")
             ;
 
         po::variables_map vm;
@@ -138,14 +409,32 @@ int main(int argc, char *argv[]) {
             if (action == "locate") {
                 isLocate = true;
             }
+            else if (action == "map") {
+                isMap = true;
+            }
             else if (action != "count") {
-                std::cerr << "Wrong action type, available options are locate and count\n";
+                std::cerr << "Wrong action type, available options are locate, count and map\n";
                 return -1;
             }
         }
         if (vm.count("out")) {
             save_file = true;
         }
+        if (vm.count("sharded")) {
+            sharded = true;
+        }
+        if (threads < 0) {
+            std::cerr << "Number of threads can't be negative.\n";
+            return -1;
+        }
+        if (errors < 0) {
+            std::cerr << "Maximal edit distance can't be negative.\n";
+            return -1;
+        }
+        if (isMap && sharded) {
+            std::cerr << "Reads can't be mapped on sharded indexes.\n";
+            return -1;
+        }
     }
     catch (std::exception& e) {
         std::cout << e.what() << "\n";
@@ -153,30 +442,33 @@ int main(int argc, char *argv[]) {
     }
 
     try {
-        Index *index = load_from_file(input_file);
-        std::cout << "Loaded " << index->get_size_in_mega_bytes() << "[mb] into memory.\n";
-        if (save_file) {
-            std::filebuf fb;
-            fb.open(output_file, std::ios::out);
-            std::ostream out(&fb);
-
-            if (isLocate) {
-                locate(index, pattern_file, out);
-            }
-            else {
-                count(index, pattern_file, out);
-            }
-
-            fb.close();
+        TaskScheduler *scheduler = nullptr;
+        if (threads != 1)
+            scheduler = new TaskScheduler((TaskScheduler::size_type) threads);
+        batch = batch || scheduler != nullptr;
+
+        if (sharded) {
+            ShardedIndex *index = ShardedIndex::load_manifest(input_file.c_str());
+            std::cout << "Loaded " << index->get_shards_number() << " shards, "
+                << index->get_size_in_mega_bytes() << "[mb] into memory.\n";
+            run_queries(index, isLocate, batch, scheduler, pattern_file, save_file, output_file);
+            delete index;
         }
         else {
-            if (isLocate) {
-                locate(index, pattern_file, std::cout);
-            }
-            else {
-                count(index, pattern_file, std::cout);
+            Index *index = load_from_file(input_file);
+            std::cout << "Loaded " << index->get_size_in_mega_bytes() << "[mb] into memory.\n";
+            if (stats) {
+                print_directory(index);
+                print_text(index);
             }
+            print_levels(index);
+            if (isMap)
+                run_mapping(index, (ulong) errors, scheduler, pattern_file, save_file, output_file);
+            else
+                run_queries(index, isLocate, batch, scheduler, pattern_file, save_file, output_file);
+            delete index;
         }
+        delete scheduler;
     }
     catch (std::exception &exception) {
         std::cerr << exception.what() << "\n";
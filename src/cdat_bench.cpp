@@ -0,0 +1,132 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#include "Counter.hpp"
+#include "IndexBitVector.hpp"
+
+#include <sys/time.h>
+
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+
+using namespace cdat;
+namespace po = boost::program_options;
+
+double seconds_since(timeval const &start) {
+    timeval now;
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec) / 1e6;
+}
+
+/*
+ * Bit vector index running the steps of Index::build itself, so the counting
+ * pass and the permutation pass (create_permutation with inc_counter, set_field
+ * and fill_text) are timed with one counter storage policy.
+ */
+class BenchIndex : public IndexBitVector {
+ public:
+  BenchIndex(size_type word_size, size_type shift) : IndexBitVector(word_size, shift) {};
+
+  template<typename t_counter>
+  int run_passes(char const *name, char const *filename) {
+      if (create_alphabet(filename) != 0)
+          return -1;
+
+      std::ifstream file(filename);
+      size_type words_number = m_alphabet->pow_wsize(m_word_size);
+      t_counter counter(words_number);
+      std::vector<size_type> cuts;
+
+      timeval start;
+      gettimeofday(&start, NULL);
+      size_type genome_words_number = counter.build_counter(file, m_word_size, m_shift, m_alphabet,
+                                                            m_text_length, m_additional_text_length, cuts);
+      double count_time = seconds_since(start);
+
+      file.clear();
+      file.seekg(0, std::ios::beg);
+      create_bit_vector(counter, words_number, genome_words_number);
+      create_text(filename);
+      m_permutation = create_permutation(genome_words_number, grid_words_number());
+      counter.prepare_for_permutation();
+
+      gettimeofday(&start, NULL);
+      create_permutation(file, counter, cuts);
+      double permutation_time = seconds_since(start);
+
+      value_type checksum = 0;
+      for (size_type i = 0; i < genome_words_number; ++i)
+          checksum = checksum * 31 + m_permutation->pi(i);
+
+      std::cout << name << "\tcount " << (uint64_t) (genome_words_number / count_time)
+                << " words/s\tpermutation " << (uint64_t) (genome_words_number / permutation_time)
+                << " words/s\tchecksum " << checksum << "\n";
+
+      return 0;
+  }
+};
+
+// every policy gets an index of its own, the passes fill its directory, permutation and text
+template<typename t_counter>
+int bench(char const *name, std::string const &filename, uint64_t const word_size, uint64_t const shift) {
+    BenchIndex index(word_size, shift);
+    return index.run_passes<t_counter>(name, filename.c_str());
+}
+
+int main(int argc, char *argv[]) {
+    std::string input_file;
+    unsigned long long word_size;
+    unsigned long long shift;
+
+    try {
+        po::options_description desc("Measures counter storage policies on the passes of cdat_build.\n\nAllowed options");
+        desc.add_options()
+            ("help,h", "produce a help message")
+            ("in,i", po::value<std::string>(&input_file)->required(), "input file with text")
+            ("size,s", po::value<unsigned long long>(&word_size)->required(), "word size")
+            ("shift,f", po::value<unsigned long long>(&shift)->default_value(1), "shift")
+            ;
+
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+
+        if (vm.count("help")) {
+            std::cout << desc;
+            return 0;
+        }
+
+        po::notify(vm);
+    }
+    catch (std::exception& e) {
+        std::cout << e.what() << "\n";
+        return -1;
+    }
+
+    std::ifstream file(input_file);
+    if (!file.is_open() || shift == 0 || shift > word_size) {
+        std::cerr << "Error: unable to open file or wrong shift\n";
+        return -1;
+    }
+
+    if (bench<Counter<32> >("Counter<32>", input_file, word_size, shift) != 0 ||
+        bench<CounterHashMap<8> >("CounterHashMap<8>", input_file, word_size, shift) != 0 ||
+        bench<CounterBitVector<8> >("CounterBitVector<8>", input_file, word_size, shift) != 0)
+        return -1;
+
+    return 0;
+}
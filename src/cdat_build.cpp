@@ -18,6 +18,9 @@
 #include "Index.hpp"
 #include "IndexPerm.hpp"
 #include "IndexBitVector.hpp"
+#include "IndexDna.hpp"
+#include "IndexMinimizer.hpp"
+#include "IndexTwoLevel.hpp"
 #include "IndexWaveletTree.hpp"
 
 #include <boost/program_options/options_description.hpp>
@@ -27,7 +30,7 @@
 using namespace cdat;
 namespace po = boost::program_options;
 
-void validate(int const size, int const shift) {
+void validate(int const size, int const shift, bool const window) {
     if (size <= 0) {
         throw std::runtime_error("Size must be greater than 0.");
     }
@@ -36,7 +39,8 @@ void validate(int const size, int const shift) {
         throw std::runtime_error("Shift must be greater than 0.");
     }
 
-    if (shift > size) {
+    // minimizer windows may be longer than words
+    if (shift > size && !window) {
         throw std::runtime_error("Shift cannot be greater than size.");
     }
 }
@@ -55,6 +59,18 @@ int main(int argc, char *argv[]) {
     std::string index_type;
     int size;
     int shift;
+    bool qgram_table = false;
+    bool suffix_directory = false;
+    int inverse_sampling = 0;
+    int repeat_threshold = 0;
+    int colocated_leading = 0;
+    int pair_filter_bits = 0;
+    int long_size = 0;
+    int long_shift = 0;
+    std::string directory_type;
+    std::string text_type;
+    std::string masked_file;
+    std::string records_file;
 
     try {
         po::options_description desc("Allowed options");
@@ -63,8 +79,20 @@ int main(int argc, char *argv[]) {
             ("in,i", po::value<std::string>(&input_file)->required(), "input file with text")
             ("out,o", po::value<std::string>(&output_file)->required(), "output file in which index will be saved")
             ("size,s", po::value<int>(&size)->required(), "size of the words to be indexed")
-            ("shift,f", po::value<int>(&shift)->required(), "shift value, 1 <= shift <= size")
-            ("type,t", po::value<std::string>(&index_type)->default_value("bit"), "index type <bit | wt | perm>")
+            ("shift,f", po::value<int>(&shift)->required(), "shift value, 1 <= shift <= size, window of minimizers for min index type, where patterns shorter than the window are answered by a linear scan of the text")
+            ("type,t", po::value<std::string>(&index_type)->default_value("bit"), "index type <bit | wt | perm | dna | min | two>")
+            ("qgrams,q", po::bool_switch(&qgram_table), "store counts of words shorter than size for fast count of short patterns")
+            ("suffix,x", po::bool_switch(&suffix_directory), "store second directory ordered by word suffixes for fast search of short patterns")
+            ("inverse-sampling,r", po::value<int>(&inverse_sampling)->default_value(0), "sample inverse permutation every r-th element, only for perm index type, 0 stores it whole")
+            ("directory,d", po::value<std::string>(&directory_type)->default_value("plain"), "bucket directory bit vector <plain | sd | rrr>")
+            ("repeats,c", po::value<int>(&repeat_threshold)->default_value(0), "order buckets with more than c positions by the following word, 0 disables")
+            ("colocate,k", po::value<int>(&colocated_leading)->default_value(0), "store bucket bounds of every 4 words together with the first k positions of their buckets, 0 disables")
+            ("pair-filter,p", po::value<int>(&pair_filter_bits)->default_value(0), "store a filter of pairs of consecutive indexed words with p bits per pair, patterns with an absent pair skip verification, 0 disables")
+            ("long-size,l", po::value<int>(&long_size)->default_value(0), "size of the words of the second level of two index type, greater than size")
+            ("long-shift,g", po::value<int>(&long_shift)->default_value(0), "shift of the second level of two index type, 0 uses shift")
+            ("masked,m", po::value<std::string>(&masked_file), "file with runs cut out of the text by replace_dna -r, positions are reported in the original text")
+            ("records,n", po::value<std::string>(&records_file), "file with record starts written by replace_dna -f, occurrences spanning records are dropped")
+            ("wt-text,w", po::value<std::string>(&text_type)->default_value("huff"), "wavelet structure storing the text of wt index type <huff | matrix | il | hyb>")
         ;
 
         po::variables_map vm;
@@ -76,34 +104,136 @@ int main(int argc, char *argv[]) {
         }
 
         po::notify(vm);
-        validate(size, shift);
+        validate(size, shift, index_type == "min");
     }
     catch (std::exception& e) {
         std::cout << e.what() << "\n";
         return 0;
     }
 
+    if (index_type == "min" && (suffix_directory || repeat_threshold != 0 ||
+                                colocated_leading != 0 || pair_filter_bits != 0)) {
+        std::cerr << "Suffix directory, repeat buckets, colocated directory and pair filter are not available for min index type.\n";
+        return -1;
+    }
+
+    if (long_shift == 0)
+        long_shift = shift;
+    if (index_type == "two" && (long_size <= size || long_shift <= 0 || long_shift > long_size)) {
+        std::cerr << "Two index type needs long size greater than size and 1 <= long shift <= long size.\n";
+        return -1;
+    }
+
+    uint directory = BucketDirectory::PLAIN;
+    if (!BucketDirectory::parse_type(directory_type, &directory)) {
+        std::cerr << "Wrong directory type, available options are: plain, sd, rrr.\n";
+        return -1;
+    }
+
+    uint wavelet_text = WaveletText::HUFFMAN;
+    if (!WaveletText::parse_type(text_type, &wavelet_text)) {
+        std::cerr << "Wrong wavelet text type, available options are: huff, matrix, il, hyb.\n";
+        return -1;
+    }
+
+    if (repeat_threshold < 0) {
+        std::cerr << "Repeat threshold must be non-negative.\n";
+        return -1;
+    }
+
+    if (colocated_leading < 0) {
+        std::cerr << "Colocated positions number must be non-negative.\n";
+        return -1;
+    }
+
+    if (pair_filter_bits < 0) {
+        std::cerr << "Pair filter bits must be non-negative.\n";
+        return -1;
+    }
+
+    if (inverse_sampling < 0) {
+        std::cerr << "Inverse sampling must be non-negative.\n";
+        return -1;
+    }
+
     Index *index = nullptr;
+    IndexMinimizer *minimizer_index = nullptr;
+    IndexTwoLevel *two_level_index = nullptr;
     if (index_type == "perm") {
-        index = new IndexPerm((size_t) size, (size_t) shift);
+        IndexPerm *perm_index = new IndexPerm((size_t) size, (size_t) shift);
+        perm_index->set_inverse_sampling((size_t) inverse_sampling);
+        index = perm_index;
     }
     else if (index_type == "wt") {
-        index = new IndexWaveletTree((size_t) size, (size_t) shift);
+        IndexWaveletTree *wt_index = new IndexWaveletTree((size_t) size, (size_t) shift);
+        wt_index->set_text_type(wavelet_text);
+        index = wt_index;
     }
     else if (index_type == "bit") {
         index = new IndexBitVector((size_t) size, (size_t) shift);
     }
+    else if (index_type == "dna") {
+        index = new IndexDna((size_t) size, (size_t) shift);
+    }
+    else if (index_type == "min") {
+        minimizer_index = new IndexMinimizer((size_t) size, (size_t) shift);
+        index = minimizer_index;
+    }
+    else if (index_type == "two") {
+        two_level_index = new IndexTwoLevel((size_t) size, (size_t) shift,
+                                            (size_t) long_size, (size_t) long_shift);
+        index = two_level_index;
+    }
     else {
-        std::cerr << "Wrong index type, available options are: bit, perm, wt.\n";
+        std::cerr << "Wrong index type, available options are: bit, perm, wt, dna, min, two.\n";
         return -1;
     }
 
+    index->set_qgram_table(qgram_table);
+    index->set_suffix_directory(suffix_directory);
+    index->set_directory_type(directory);
+    index->set_repeat_threshold((size_t) repeat_threshold);
+    index->set_colocated_directory((size_t) colocated_leading);
+    index->set_pair_filter((size_t) pair_filter_bits);
+
+    if (!masked_file.empty()) {
+        MaskedRuns *masked_runs = new MaskedRuns();
+        if (masked_runs->build(masked_file.c_str()) != 0) {
+            delete masked_runs;
+            delete index;
+            return -1;
+        }
+        index->set_masked_runs(masked_runs);
+    }
+
+    if (!records_file.empty()) {
+        Records *records = new Records();
+        if (records->build(records_file.c_str()) != 0) {
+            delete records;
+            delete index;
+            return -1;
+        }
+        index->set_records(records);
+    }
+
     std::cout << "Started building index.\n";
     timeval start, stop, t2;
     unsigned long time = 0;
     gettimeofday(&start, NULL);
 
-    index->build<Counter<32> >(input_file.c_str());
+    // minimizer index samples positions on its own, without word counter
+    int result;
+    if (minimizer_index != nullptr)
+        result = minimizer_index->build(input_file.c_str());
+    else if (two_level_index != nullptr)
+        result = two_level_index->build<Counter<32> >(input_file.c_str());
+    else
+        result = index->build<Counter<32> >(input_file.c_str());
+    if (result != 0) {
+        std::cerr << "Index couldn't be built.\n";
+        delete index;
+        return -1;
+    }
     save_to_file(index, output_file);
 
     gettimeofday(&stop, NULL);
@@ -113,6 +243,10 @@ int main(int argc, char *argv[]) {
     std::cout << "Index has been built in " << time / 1000.0 << "[s] and saved to file: \'"
               << output_file << "\'.\n";
     std::cout << "Index size: " << index->get_size_in_mega_bytes() << "[mb].\n";
+    if (two_level_index != nullptr) {
+        std::cout << "Short level: " << two_level_index->get_short_size_in_mega_bytes()
+            << "[mb] with text, long level: " << two_level_index->get_long_size_in_mega_bytes() << "[mb].\n";
+    }
 
     return 0;
 }
@@ -0,0 +1,79 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#include "Index.hpp"
+
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+
+using namespace cdat;
+namespace po = boost::program_options;
+
+// reads an index saved in any supported file version and saves it in the current one
+int main(int argc, char *argv[]) {
+    std::string input_file;
+    std::string output_file;
+
+    try {
+        po::options_description desc("Allowed options");
+        desc.add_options()
+            ("help,h", "produce a help message")
+            ("in,i", po::value<std::string>(&input_file)->required(), "index file built by an earlier cdat_build")
+            ("out,o", po::value<std::string>(&output_file)->required(), "output file in which converted index will be saved")
+            ;
+
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+
+        if (vm.count("help")) {
+            std::cout << desc;
+            return 0;
+        }
+
+        po::notify(vm);
+    }
+    catch (std::exception& e) {
+        std::cout << e.what() << "\n";
+        return -1;
+    }
+
+    std::ifstream in(input_file, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Error: could not open file \"" << input_file << "\"\n";
+        return -1;
+    }
+
+    Index *index;
+    try {
+        index = Index::load_index(in);
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return -1;
+    }
+
+    std::filebuf fb;
+    fb.open(output_file, std::ios::out);
+    std::ostream out(&fb);
+    index->save_index(out);
+    fb.close();
+
+    std::cout << "Index has been saved to file: \'" << output_file << "\'.\n";
+    delete index;
+    return 0;
+}
@@ -57,6 +57,8 @@ char replace(char const letter) {
 int main(int argc, char *argv[]) {
     std::string input_file;
     std::string output_file;
+    std::string runs_file;
+    std::string records_file;
 
     try {
         po::options_description desc("Replaces characters in text with \'A\', \'C\', \'G\', \'T\'.\n\nAllowed options");
@@ -64,6 +66,8 @@ int main(int argc, char *argv[]) {
             ("help,h", "produce a help message")
             ("in,i", po::value<std::string>(&input_file)->required(), "input file")
             ("out,o", po::value<std::string>(&output_file)->required(), "file to write results.")
+            ("runs,r", po::value<std::string>(&runs_file), "cut runs of other characters out of the text instead of replacing them, write them as lines \"position length\" to this file for cdat_build -m")
+            ("fasta,f", po::value<std::string>(&records_file), "read input as multi-FASTA, skip header lines and line breaks, write record starts as lines \"position name\" to this file for cdat_build -n")
         ;
 
         po::variables_map vm;
@@ -91,20 +95,85 @@ int main(int argc, char *argv[]) {
     std::filebuf fb;
     fb.open(output_file.c_str(), std::ios::out);
     std::ostream out(&fb);
+
+    std::ofstream runs;
+    if (!runs_file.empty())
+        runs.open(runs_file.c_str());
+    std::ofstream records;
+    if (!records_file.empty())
+        records.open(records_file.c_str());
+    bool header = false;
+    bool line_start = true;
+    bool pending_record = false;
+    std::string name;
+
+    unsigned long long position = 0;
+    unsigned long long run_start = 0;
+    unsigned long long run_length = 0;
+
     do {
         file.read(buffer, BUFFER_SIZE);
         bytes_read = (size_t) file.gcount();
 
+        size_t kept = 0;
         for (size_t i = 0; i < bytes_read; ++i) {
-            if (buffer[i] != 'A' && buffer[i] != 'C' && buffer[i] != 'G' && buffer[i] != 'T') {
-                buffer[i] = replace(buffer[i]);
+            // header names the record starting at its first character, first word only,
+            // records without characters are skipped
+            if (records.is_open()) {
+                if (header) {
+                    if (buffer[i] == '\n') {
+                        name = name.substr(0, name.find_first_of(" \t\r"));
+                        pending_record = true;
+                        header = false;
+                        line_start = true;
+                    }
+                    else {
+                        name += buffer[i];
+                    }
+                    continue;
+                }
+
+                if (line_start && buffer[i] == '>') {
+                    header = true;
+                    name.clear();
+                    continue;
+                }
+
+                line_start = buffer[i] == '\n';
+                if (buffer[i] == '\n' || buffer[i] == '\r')
+                    continue;
+
+                if (pending_record) {
+                    records << position << " " << name << "\n";
+                    pending_record = false;
+                }
+            }
+
+            if (buffer[i] == 'A' || buffer[i] == 'C' || buffer[i] == 'G' || buffer[i] == 'T') {
+                if (run_length > 0) {
+                    runs << run_start << " " << run_length << "\n";
+                    run_length = 0;
+                }
+                buffer[kept++] = buffer[i];
             }
+            else if (runs.is_open()) {
+                if (run_length == 0)
+                    run_start = position;
+                ++run_length;
+            }
+            else {
+                buffer[kept++] = replace(buffer[i]);
+            }
+            ++position;
         }
 
-        out.write(buffer, bytes_read);
+        out.write(buffer, kept);
     }
     while (bytes_read == BUFFER_SIZE);
 
+    if (run_length > 0)
+        runs << run_start << " " << run_length << "\n";
+
     fb.close();
     file.close();
     return 0;
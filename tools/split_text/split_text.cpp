@@ -0,0 +1,99 @@
+/* cdat - compressed direct-address tables
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/ .
+*/
+
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+
+using namespace std;
+namespace po = boost::program_options;
+
+int main(int argc, char *argv[]) {
+    std::string input_file;
+    std::string output_prefix;
+    unsigned long long shards_number;
+    unsigned long long overlap;
+
+    try {
+        po::options_description desc("Splits text into overlapping shards and writes a manifest for cdat -s.\n\nAllowed options");
+        desc.add_options()
+            ("help,h", "produce a help message")
+            ("in,i", po::value<std::string>(&input_file)->required(), "input file")
+            ("out,o", po::value<std::string>(&output_prefix)->required(), "prefix of shard files, shard i is written to prefix.i and has to be indexed to prefix.i.idx, manifest is written to prefix.manifest")
+            ("shards,n", po::value<unsigned long long>(&shards_number)->required(), "number of shards")
+            ("overlap,v", po::value<unsigned long long>(&overlap)->default_value(255), "characters shared with the next shard, patterns up to overlap + 1 characters are found across shard borders")
+        ;
+
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+
+        if (vm.count("help")) {
+            std::cout << desc;
+            return 0;
+        }
+
+        po::notify(vm);
+    }
+    catch (std::exception& e) {
+        std::cout << e.what() << "\n";
+        return 0;
+    }
+
+    ifstream file(input_file.c_str());
+    if (!file.is_open() || shards_number == 0) {
+        std::cerr << "Error: unable to open file or no shards requested\n";
+        return -1;
+    }
+
+    file.seekg(0, std::ios::end);
+    unsigned long long text_length = file.tellg();
+    unsigned long long shard_length = (text_length + shards_number - 1) / shards_number;
+
+    const size_t BUFFER_SIZE = 16 * 1024;
+    char buffer[BUFFER_SIZE];
+
+    // shard i owns [offset, offset + length) and also stores the next overlap characters
+    std::ofstream manifest((output_prefix + ".manifest").c_str());
+    manifest << "overlap " << overlap << "\n";
+    std::string name = output_prefix.substr(output_prefix.find_last_of('/') + 1);
+
+    for (unsigned long long i = 0; i * shard_length < text_length; ++i) {
+        unsigned long long offset = i * shard_length;
+        unsigned long long length = std::min(shard_length, text_length - offset);
+        unsigned long long end = std::min(text_length, offset + length + overlap);
+
+        std::ofstream out((output_prefix + "." + std::to_string(i)).c_str());
+        file.clear();
+        file.seekg(offset);
+        for (unsigned long long position = offset; position < end; ) {
+            size_t chunk = (size_t) std::min((unsigned long long) BUFFER_SIZE, end - position);
+            file.read(buffer, chunk);
+            out.write(buffer, chunk);
+            position += chunk;
+        }
+
+        manifest << name << "." << i << ".idx " << offset << " " << length << "\n";
+    }
+
+    file.close();
+    return 0;
+}